@@ -0,0 +1,412 @@
+#include <iostream>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+#include <random>
+#include <memory>
+#include <cstdlib>
+#include <cmath>
+#include "../BlackScholesOptionPricer/BlackScholesOptionPricer.hpp"
+#include "../BlackScholesOptionPricer/ImpliedVolatility.hpp"
+#include "../BlackScholesOptionPricer/OptionChain.hpp"
+#include "../ComputeYieldNewtonMethod/ComputeYieldNewtonMethod.hpp"
+#include "../MonteCarloOptionPricing/SDE.hpp"
+#include "../MonteCarloOptionPricing/FDM.hpp"
+#include "../MonteCarloOptionPricing/RNG.hpp"
+#include "../MonteCarloOptionPricing/Sobol.hpp"
+#include "../MonteCarloOptionPricing/Pricer.hpp"
+#include "../MonteCarloOptionPricing/Engine.hpp"
+
+// Micro benchmarks for every pricing kernel in the repository
+//
+// Each kernel is timed in isolation for several input sizes. Every measurement is repeated and the fastest
+// repetition is kept, results go to stdout as CSV (kernel,size,ns_per_op,ops_per_second) so runs can be diffed.
+//
+// benchmark [filter]     only kernels whose name contains filter are run
+// benchmark --rng-moments  check every normal generator's moments and tails against the exact values instead
+
+// results are accumulated here so the compiler can not drop the timed work
+volatile double sink = 0;
+
+std::string filter;
+
+// time body(), which performs `ops` operations, and print one CSV row
+void run(const std::string& kernel, std::size_t size, std::size_t ops, const std::function<void()>& body) {
+    if (kernel.find(filter) == std::string::npos)
+        return;
+
+    const int repetitions = 5;
+    const double minimumSeconds = 0.05;
+
+    // grow the number of calls until one repetition is long enough to time reliably
+    std::size_t calls = 1;
+    double best = 0;
+    for (;;)
+    {
+        std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < calls; i++)
+            body();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        if (elapsed.count() >= minimumSeconds) {
+            best = elapsed.count();
+            break;
+        }
+        calls *= 2;
+    }
+
+    for (int r = 1; r < repetitions; r++)
+    {
+        std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < calls; i++)
+            body();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        if (elapsed.count() < best)
+            best = elapsed.count();
+    }
+
+    double seconds = best / (double(calls) * double(ops));
+    std::cout << kernel << "," << size << "," << seconds * 1e9 << "," << 1.0 / seconds << std::endl;
+}
+
+std::vector<double> uniformVector(std::size_t n, double low, double high, unsigned seed) {
+    std::mt19937 engine(seed);
+    std::uniform_real_distribution<double> uniform(low, high);
+    std::vector<double> v(n);
+    for (std::size_t i = 0; i < n; i++)
+        v[i] = uniform(engine);
+    return v;
+}
+
+void benchmarkBlackScholes() {
+    const std::size_t sizes[] = { 1000, 100000 };
+
+    for (std::size_t n : sizes)
+    {
+        std::vector<double> d = uniformVector(n, -4, 4, 1);
+        run("BlackScholesOptionPricer::N", n, n, [&]() {
+            double total = 0;
+            for (std::size_t i = 0; i < n; i++)
+                total += BlackScholesOptionPricer::N(d[i]);
+            sink = sink + total;
+        });
+
+        std::vector<double> spot(n, 100.0);
+        std::vector<double> strike = uniformVector(n, 50, 150, 2);
+        std::vector<double> rate = uniformVector(n, 0, 0.05, 3);
+        std::vector<double> dividend = uniformVector(n, 0, 0.03, 4);
+        std::vector<double> vol = uniformVector(n, 0.1, 0.6, 5);
+        std::vector<double> expiry = uniformVector(n, 0.05, 2, 6);
+        std::vector<double> call(n), put(n);
+
+        run("BlackScholesOptionPricer::callPrice", n, n, [&]() {
+            double total = 0;
+            for (std::size_t i = 0; i < n; i++)
+                total += BlackScholesOptionPricer(spot[i], strike[i], rate[i], dividend[i], vol[i], expiry[i]).callPrice();
+            sink = sink + total;
+        });
+
+        run("BlackScholesOptionPricer::priceBatch", n, n, [&]() {
+            BlackScholesOptionPricer::priceBatch(n, spot.data(), strike.data(), rate.data(), dividend.data(), vol.data(), expiry.data(), call.data(), put.data());
+            sink = sink + call[n / 2];
+        });
+
+        std::vector<BlackScholesGreeks> callGreeks(n), putGreeks(n);
+        run("BlackScholesOptionPricer::greeksBatch", n, n, [&]() {
+            BlackScholesOptionPricer::greeksBatch(n, spot.data(), strike.data(), rate.data(), dividend.data(), vol.data(), expiry.data(), callGreeks.data(), putGreeks.data());
+            sink = sink + callGreeks[n / 2].delta;
+        });
+
+        std::unique_ptr<bool[]> isCall(new bool[n]);
+        for (std::size_t i = 0; i < n; i++)
+            isCall[i] = strike[i] > spot[i];
+        std::vector<double> quotes(n), impliedVolatility(n);
+        std::vector<int> iterations(n);
+        for (std::size_t i = 0; i < n; i++)
+            quotes[i] = isCall[i] ? call[i] : put[i];
+
+        ImpliedVolatilitySolver solver;
+        run("ImpliedVolatilitySolver::solveBatch", n, n, [&]() {
+            solver.solveBatch(n, quotes.data(), isCall.get(), spot.data(), strike.data(), rate.data(), dividend.data(), expiry.data(), impliedVolatility.data(), iterations.data());
+            sink = sink + impliedVolatility[n / 2];
+        });
+
+        OptionChain chain(100, 0.03, 0.01, 0.5, strike);
+        run("OptionChain::price", n, n, [&]() {
+            chain.setStockPrice(100);
+            chain.price(vol.data(), call.data(), put.data());
+            sink = sink + call[n / 2];
+        });
+    }
+}
+
+void benchmarkYield() {
+    // bonds of 1, 5 and 30 years paying semiannual coupons
+    const int months[] = { 12, 60, 360 };
+
+    for (int m : months)
+    {
+        ComputeYieldNewtonMethod bond(m, 6, 0.04, 100, 98);
+        run("ComputeYieldNewtonMethod::getYieldDurationConvexity", std::size_t(m), 1, [&]() {
+            sink = sink + std::get<0>(bond.getYieldDurationConvexity(0.01));
+        });
+    }
+}
+
+std::vector<std::pair<std::string, std::shared_ptr<IRNG>> > normalGenerators() {
+    std::vector<std::pair<std::string, std::shared_ptr<IRNG>> > generators;
+    generators.push_back(std::make_pair(std::string("MTNormalRNG"), std::shared_ptr<IRNG>(std::make_shared<MTNormalRNG>(0, 1))));
+    generators.push_back(std::make_pair(std::string("BoxMullerRNG"), std::shared_ptr<IRNG>(std::make_shared<BoxMullerRNG>())));
+    generators.push_back(std::make_pair(std::string("PolarMarsagliaRNG"), std::shared_ptr<IRNG>(std::make_shared<PolarMarsagliaRNG>())));
+    generators.push_back(std::make_pair(std::string("PhiloxRNG"), std::shared_ptr<IRNG>(std::make_shared<PhiloxRNG>(42, 0))));
+    generators.push_back(std::make_pair(std::string("ZigguratRNG"), std::shared_ptr<IRNG>(std::make_shared<ZigguratRNG>(42))));
+    return generators;
+}
+
+void benchmarkRng() {
+    const std::size_t n = 100000;
+
+    std::vector<std::pair<std::string, std::shared_ptr<IRNG>> > generators = normalGenerators();
+
+    for (auto& generator : generators)
+    {
+        IRNG& rng = *generator.second;
+        run(generator.first + "::GenerateRng", n, n, [&]() {
+            double total = 0;
+            for (std::size_t i = 0; i < n; i++)
+                total += rng.GenerateRng();
+            sink = sink + total;
+        });
+
+        std::vector<double> buffer(n);
+        run(generator.first + "::Fill", n, n, [&]() {
+            rng.Fill(buffer.data(), n);
+            sink = sink + buffer[n - 1];
+        });
+    }
+
+    // quasi random normals come one path (one Sobol point) per Fill, with and without the Brownian bridge
+    const std::size_t steps = 64;
+    const std::size_t points = n / steps;
+    std::vector<double> path(steps);
+    SobolRNG sobol(true, 42, false);
+    SobolRNG sobolBridge(true, 42, true);
+    run("SobolRNG::Fill", steps, points * steps, [&]() {
+        for (std::size_t p = 0; p < points; p++)
+            sobol.Fill(path.data(), steps);
+        sink = sink + path[steps - 1];
+    });
+    run("SobolRNG::Fill+BrownianBridge", steps, points * steps, [&]() {
+        for (std::size_t p = 0; p < points; p++)
+            sobolBridge.Fill(path.data(), steps);
+        sink = sink + path[steps - 1];
+    });
+}
+
+// moments and two-sided tail frequencies of 10^8 draws per generator (through Fill), with the exact N(0,1) values first
+// and the z-score of each tail count, |z| above about 4 points at a broken generator
+void validateRng() {
+    const std::size_t block = 1 << 20;
+    const int blocks = 96;
+    const double thresholds[] = { 3, 4, 5 };
+
+    std::cout << "generator,draws,mean,variance,skewness,excess_kurtosis,tail_3,tail_4,tail_5,z_3,z_4,z_5" << std::endl;
+    std::cout << "exact,0,0,1,0,0";
+    for (double t : thresholds)
+        std::cout << "," << std::erfc(t / std::sqrt(2.0));
+    std::cout << ",0,0,0" << std::endl;
+
+    std::vector<double> buffer(block);
+    for (auto& generator : normalGenerators())
+    {
+        double s1 = 0, s2 = 0, s3 = 0, s4 = 0;
+        double tails[3] = { 0, 0, 0 };
+        for (int b = 0; b < blocks; b++)
+        {
+            generator.second->Fill(buffer.data(), block);
+            for (double x : buffer)
+            {
+                double x2 = x * x;
+                s1 += x;
+                s2 += x2;
+                s3 += x2 * x;
+                s4 += x2 * x2;
+                for (int k = 0; k < 3; k++)
+                    tails[k] += std::abs(x) > thresholds[k];
+            }
+        }
+
+        double n = double(block) * blocks;
+        double mean = s1 / n;
+        double variance = s2 / n - mean * mean;
+        std::cout << generator.first << "," << n << "," << mean << "," << variance << ","
+            << (s3 / n) / std::pow(variance, 1.5) << "," << (s4 / n) / (variance * variance) - 3;
+        for (int k = 0; k < 3; k++)
+            std::cout << "," << tails[k] / n;
+        for (int k = 0; k < 3; k++)
+        {
+            double expected = n * std::erfc(thresholds[k] / std::sqrt(2.0));
+            std::cout << "," << (tails[k] - expected) / std::sqrt(expected);
+        }
+        std::cout << std::endl;
+    }
+}
+
+void benchmarkFdm() {
+    const int steps = 1000;
+    const double T = 1.0;
+
+    std::vector<std::pair<std::string, SDEPointer> > sdes;
+    sdes.push_back(std::make_pair(std::string("GBM"), SDEPointer(std::make_shared<GBM>(0.05, 0.2, 0.01, 100, T))));
+    sdes.push_back(std::make_pair(std::string("CEV"), SDEPointer(std::make_shared<CEV>(0.05, 0.2, 0.01, 100, T, 0.5))));
+
+    std::vector<double> normals(steps);
+    MTNormalRNG rng(0, 1);
+    for (int i = 0; i < steps; i++)
+        normals[i] = rng.GenerateRng();
+
+    for (auto& sde : sdes)
+    {
+        std::vector<std::pair<std::string, std::shared_ptr<IFDM> > > schemes;
+        schemes.push_back(std::make_pair(std::string("EulerFDM"), std::shared_ptr<IFDM>(std::make_shared<EulerFDM>(sde.second, steps))));
+        schemes.push_back(std::make_pair(std::string("MilsteinFDM"), std::shared_ptr<IFDM>(std::make_shared<MilsteinFDM>(sde.second, steps))));
+        schemes.push_back(std::make_pair(std::string("ModifiedPredictorCorrectorFDM"), std::shared_ptr<IFDM>(std::make_shared<ModifiedPredictorCorrectorFDM>(sde.second, steps, 0.5, 0.5))));
+        if (auto gbm = std::dynamic_pointer_cast<GBM>(sde.second))
+            schemes.push_back(std::make_pair(std::string("ExactGBMFDM"), std::shared_ptr<IFDM>(std::make_shared<ExactGBMFDM>(gbm, steps))));
+
+        for (auto& scheme : schemes)
+        {
+            IFDM& fdm = *scheme.second;
+            run(scheme.first + "<" + sde.first + ">::advance", std::size_t(steps), std::size_t(steps), [&]() {
+                double x = 100;
+                for (int n = 0; n < steps; n++)
+                    x = fdm.advance(x, fdm.m_vec[n], fdm.m_k, normals[n]);
+                sink = sink + x;
+            });
+
+            // a whole path into its running state, through the virtual classes and through the compile time engine
+            PathState state;
+            run(scheme.first + "<" + sde.first + ">::path", std::size_t(steps), std::size_t(steps), [&]() {
+                double x = 100;
+                state.Start(x);
+                for (int n = 0; n < steps; n++)
+                {
+                    x = fdm.advance(x, fdm.m_vec[n], fdm.m_k, normals[n]);
+                    state.Add(x);
+                }
+                sink = sink + state.last;
+            });
+            std::shared_ptr<IPathEngine> engine = MakeEngine(std::make_tuple(sde.second, scheme.second, RNGPointer(std::make_shared<MTNormalRNG>(0, 1))));
+            run("MCEngine<" + sde.first + "," + scheme.first + ">::Simulate", std::size_t(steps), std::size_t(steps), [&]() {
+                engine->Simulate(normals, state);
+                sink = sink + state.last;
+            });
+
+            // lanes paths in lockstep, every lane reuses the same normals
+            const int lanes = 256;
+            AlignedVector blockNormals(std::size_t(steps) * lanes);
+            for (int n = 0; n < steps; n++)
+                for (int p = 0; p < lanes; p++)
+                    blockNormals[std::size_t(n) * lanes + p] = normals[n];
+            PathBlock block(lanes);
+            run("MCEngine<" + sde.first + "," + scheme.first + ">::SimulateBlock", std::size_t(steps), std::size_t(steps) * lanes, [&]() {
+                engine->SimulateBlock(blockNormals.data(), lanes, block);
+                sink = sink + block.State(0).last;
+            });
+
+            // the same with the Brownian bridge extremes of every step, continuous barrier monitoring
+            AlignedVector bridgedNormals(std::size_t(5 * steps) * lanes);
+            for (int n = 0; n < 5 * steps; n++)
+                for (int p = 0; p < lanes; p++)
+                    bridgedNormals[std::size_t(n) * lanes + p] = normals[n % steps];
+            engine->ContinuousMonitoring(true);
+            run("MCEngine<" + sde.first + "," + scheme.first + ">::SimulateBlock(bridged)", std::size_t(steps), std::size_t(steps) * lanes, [&]() {
+                engine->SimulateBlock(bridgedNormals.data(), lanes, block);
+                sink = sink + block.State(0).max;
+            });
+            engine->ContinuousMonitoring(false);
+        }
+    }
+}
+
+void benchmarkPricers() {
+    const std::size_t lengths[] = { 50, 500 };
+    const double strike = 100;
+
+    PayoffFunction call = [strike](const double& x) { return std::max(0.0, x - strike); };
+    AverageFunction arithmetic = [](const PathState& path) { return path.sum / double(path.points); };
+    KnockFunction upAndOut = [](const PathState& path) { return path.max >= 130; };
+
+    for (std::size_t length : lengths)
+    {
+        // a fixed set of paths so every pricer sees the same data
+        const std::size_t paths = 64;
+        std::vector<std::vector<double> > pathSet(paths);
+        MTNormalRNG rng(0, 1);
+        for (std::size_t p = 0; p < paths; p++)
+        {
+            pathSet[p].resize(length + 1);
+            pathSet[p][0] = 100;
+            for (std::size_t n = 1; n <= length; n++)
+                pathSet[p][n] = pathSet[p][n - 1] * (1 + 0.2 * std::sqrt(1.0 / length) * rng.GenerateRng());
+        }
+        std::vector<PathState> states(paths);
+        for (std::size_t p = 0; p < paths; p++)
+        {
+            states[p].Start(pathSet[p][0]);
+            for (std::size_t n = 1; n <= length; n++)
+                states[p].Add(pathSet[p][n]);
+        }
+
+        EuropeanPricer european(call, 0.95);
+        AsianPricer asian(call, 0.95, arithmetic);
+        BarrierPricer barrier(call, 0.95, upAndOut);
+
+        std::vector<std::pair<std::string, IPricer*> > pricers;
+        pricers.push_back(std::make_pair(std::string("EuropeanPricer"), static_cast<IPricer*>(&european)));
+        pricers.push_back(std::make_pair(std::string("AsianPricer"), static_cast<IPricer*>(&asian)));
+        pricers.push_back(std::make_pair(std::string("BarrierPricer"), static_cast<IPricer*>(&barrier)));
+
+        for (auto& pricer : pricers)
+        {
+            IPricer& p = *pricer.second;
+            run(pricer.first + "::ProcessPath", length, paths, [&]() {
+                for (std::size_t i = 0; i < paths; i++)
+                    p.ProcessPath(states[i]);
+            });
+        }
+
+        // streaming a stored path into its running state, done once per path whatever the number of pricers
+        run("PathState::Add", length, paths, [&]() {
+            for (std::size_t i = 0; i < paths; i++)
+            {
+                states[i].Start(pathSet[i][0]);
+                for (std::size_t n = 1; n <= length; n++)
+                    states[i].Add(pathSet[i][n]);
+            }
+        });
+    }
+}
+
+int main(int argc, char* argv[]) {
+
+    if (argc > 1)
+        filter = argv[1];
+
+    if (filter == "--rng-moments") {
+        validateRng();
+        return 0;
+    }
+
+    std::cout << "kernel,size,ns_per_op,ops_per_second" << std::endl;
+
+    benchmarkBlackScholes();
+    benchmarkYield();
+    benchmarkRng();
+    benchmarkFdm();
+    benchmarkPricers();
+
+    return 0;
+}
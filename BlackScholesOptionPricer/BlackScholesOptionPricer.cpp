@@ -11,76 +11,154 @@ BlackScholesOptionPricer::BlackScholesOptionPricer(double stockPrice, double str
 
 double BlackScholesOptionPricer::callPrice() {
 
-    double nd1 = getNd1();
-	double nd2 = getNd2();
+    double d1, d2;
+    getD1D2(d1, d2);
 
-    return stockPrice * exp( -dividend * (expiryTime) ) * nd1 - strikePrice * exp( -interestRate * (expiryTime) ) *nd2;
+    return stockPrice * exp( -dividend * (expiryTime) ) * N(d1) - strikePrice * exp( -interestRate * (expiryTime) ) * N(d2);
 }
 
 
 double BlackScholesOptionPricer::putPrice() {
 
-    double nd1 = getNd1();
-	double nd2 = getNd2();
+    double d1, d2;
+    getD1D2(d1, d2);
     
-    return strikePrice * exp(-interestRate * (expiryTime)) * (1 - nd2) - stockPrice * exp(-dividend * (expiryTime)) * (1 - nd1);
+    return strikePrice * exp(-interestRate * (expiryTime)) * N(-d2) - stockPrice * exp(-dividend * (expiryTime)) * N(-d1);
 }
 
-double BlackScholesOptionPricer::getNd1() {
-    double d1 = ( log(stockPrice / strikePrice) + (interestRate - dividend + volatility * volatility / 2)*(expiryTime)) / (volatility * sqrt(expiryTime));
+BlackScholesGreeks BlackScholesOptionPricer::callGreeks() {
+    BlackScholesGreeks call, put;
+    greeks(stockPrice, strikePrice, interestRate, dividend, volatility, expiryTime, call, put);
+    return call;
+}
+
+BlackScholesGreeks BlackScholesOptionPricer::putGreeks() {
+    BlackScholesGreeks call, put;
+    greeks(stockPrice, strikePrice, interestRate, dividend, volatility, expiryTime, call, put);
+    return put;
+}
 
-    return N(d1);
+void BlackScholesOptionPricer::greeks(BlackScholesGreeks& call, BlackScholesGreeks& put) {
+    greeks(stockPrice, strikePrice, interestRate, dividend, volatility, expiryTime, call, put);
 }
 
-double BlackScholesOptionPricer::getNd2() {
-    double d1 = (log(stockPrice / strikePrice) + (interestRate - dividend + volatility * volatility / 2) * (expiryTime)) / (volatility * sqrt(expiryTime));
-    double d2 = d1 - volatility * (sqrt(expiryTime));
+BlackScholesExpiryTerms::BlackScholesExpiryTerms(double stockPrice, double interestRate, double dividend, double expiryTime)
+    : interestRate(interestRate), dividend(dividend), expiryTime(expiryTime) {
 
-    return N(d2);
+    sqrtT = sqrt(expiryTime);
+    dividendDiscount = exp(-dividend * expiryTime);
+    rateDiscount = exp(-interestRate * expiryTime);
+    setStockPrice(stockPrice);
 }
 
-double BlackScholesOptionPricer::f(double x) {
-	return 1 / (sqrt(2.0 * M_PI))*exp(-x*x / 2.0);
+void BlackScholesExpiryTerms::setStockPrice(double price) {
+    stockPrice = price;
+    discountedStock = stockPrice * dividendDiscount;
+    logForward = log(stockPrice) + (interestRate - dividend) * expiryTime;
 }
 
+void BlackScholesOptionPricer::greeks(double stockPrice, double strikePrice, double interestRate, double dividend, double volatility, double expiryTime,
+    BlackScholesGreeks& call, BlackScholesGreeks& put) {
 
-//Simpson's rule of finding integral(cumulative distribution of the standard normal distribution in this case)  
-double BlackScholesOptionPricer::N(double d) {
-    double n = 4;		//initial nunber of interval
-	double value = 0;
-	double total = 0;
-	double tol = pow(10, -12);		//tolerance
+    greeks(BlackScholesExpiryTerms(stockPrice, interestRate, dividend, expiryTime), strikePrice, log(strikePrice), volatility, call, put);
+}
 
+//d1, d2, the discount factors, N(d) and the pdf are computed once and shared by the call and the put
+void BlackScholesOptionPricer::greeks(const BlackScholesExpiryTerms& terms, double strikePrice, double logStrike, double volatility,
+    BlackScholesGreeks& call, BlackScholesGreeks& put) {
+
+    double stockPrice = terms.stockPrice;
+    double interestRate = terms.interestRate;
+    double dividend = terms.dividend;
+    double expiryTime = terms.expiryTime;
+    double sqrtT = terms.sqrtT;
+    double dividendDiscount = terms.dividendDiscount;
+
+    double volSqrtT = volatility * sqrtT;
+    double d1 = (terms.logForward - logStrike) / volSqrtT + volSqrtT / 2;
+    double d2 = d1 - volSqrtT;
+
+    double forward = terms.discountedStock;
+    double discountedStrike = strikePrice * terms.rateDiscount;
+
+    double nd1 = N(d1);
+    double nd2 = N(d2);
+    double nMinusd1 = N(-d1);
+    double nMinusd2 = N(-d2);
+    double pdf = f(d1);
+
+    //terms shared by the call and the put
+    double gamma = dividendDiscount * pdf / (stockPrice * volSqrtT);
+    double vega = forward * pdf * sqrtT;
+    double timeDecay = -forward * pdf * volatility / (2 * sqrtT);
+    double vanna = -dividendDiscount * pdf * d2 / volatility;
+    double volga = vega * d1 * d2 / volatility;
+    double charmDecay = -dividendDiscount * pdf * (2 * (interestRate - dividend) * expiryTime - d2 * volSqrtT) / (2 * expiryTime * volSqrtT);
+
+    call.price = forward * nd1 - discountedStrike * nd2;
+    call.delta = dividendDiscount * nd1;
+    call.gamma = gamma;
+    call.vega = vega;
+    call.theta = timeDecay - interestRate * discountedStrike * nd2 + dividend * forward * nd1;
+    call.rho = expiryTime * discountedStrike * nd2;
+    call.epsilon = -expiryTime * forward * nd1;
+    call.vanna = vanna;
+    call.volga = volga;
+    call.charm = charmDecay + dividend * dividendDiscount * nd1;
+
+    put.price = discountedStrike * nMinusd2 - forward * nMinusd1;
+    put.delta = -dividendDiscount * nMinusd1;
+    put.gamma = gamma;
+    put.vega = vega;
+    put.theta = timeDecay + interestRate * discountedStrike * nMinusd2 - dividend * forward * nMinusd1;
+    put.rho = -expiryTime * discountedStrike * nMinusd2;
+    put.epsilon = expiryTime * forward * nMinusd1;
+    put.vanna = vanna;
+    put.volga = volga;
+    put.charm = charmDecay - dividend * dividendDiscount * nMinusd1;
+}
 
-	double a = 0;	//starting point
-	double b = d;	//ending point
+void BlackScholesOptionPricer::greeksBatch(std::size_t n, const double* stockPrice, const double* strikePrice, const double* interestRate,
+    const double* dividend, const double* volatility, const double* expiryTime, BlackScholesGreeks* call, BlackScholesGreeks* put) {
 
-	double old_value;
-	double h;	//interval length
+    for (std::size_t i = 0; i < n; i++)
+    {
+        greeks(stockPrice[i], strikePrice[i], interestRate[i], dividend[i], volatility[i], expiryTime[i], call[i], put[i]);
+    }
+}
 
-	do
-	{
-		h = (b - a) / (n * 1.0);
-		old_value = value;
-		total = 0;
-		value = 0;
+void BlackScholesOptionPricer::getD1D2(double& d1, double& d2) {
+    double volSqrtT = volatility * sqrt(expiryTime);
 
-		total = (f(a) * 1 / 6) + (f(b) * 1 / 6);
+    d1 = (log(stockPrice / strikePrice) + (interestRate - dividend + volatility * volatility / 2) * (expiryTime)) / volSqrtT;
+    d2 = d1 - volSqrtT;
+}
 
-		for (int i = 1; i <= n - 1; i++)
-		{
+void BlackScholesOptionPricer::priceBatch(std::size_t n, const double* stockPrice, const double* strikePrice, const double* interestRate,
+    const double* dividend, const double* volatility, const double* expiryTime, double* callPrice, double* putPrice) {
 
-			total += 1 / 3.0 * f(a + i * h) + 2 / 3.0 * f(a + i * h - 0.5 * h);
-		}
+#pragma omp simd
+    for (std::size_t i = 0; i < n; i++)
+    {
+        double volSqrtT = volatility[i] * sqrt(expiryTime[i]);
+        double d1 = (log(stockPrice[i] / strikePrice[i]) + (interestRate[i] - dividend[i] + volatility[i] * volatility[i] / 2) * expiryTime[i]) / volSqrtT;
+        double d2 = d1 - volSqrtT;
 
-		total = total + 2 / 3.0 * f(a + n * h - 0.5 * h);
+        double forward = stockPrice[i] * exp(-dividend[i] * expiryTime[i]);
+        double discountedStrike = strikePrice[i] * exp(-interestRate[i] * expiryTime[i]);
 
+        //N(-d) = 1 - N(d), using erfc for both sides keeps the put accurate deep out of the money
+        callPrice[i] = forward * 0.5 * erfc(-d1 * M_SQRT1_2) - discountedStrike * 0.5 * erfc(-d2 * M_SQRT1_2);
+        putPrice[i] = discountedStrike * 0.5 * erfc(d2 * M_SQRT1_2) - forward * 0.5 * erfc(d1 * M_SQRT1_2);
+    }
+}
 
-		total *= h;
-		value = total + 0.5;
-		n *= 2;
-	} while (abs(value - old_value) > tol);	//loop until breaking the tolerance
+double BlackScholesOptionPricer::f(double x) {
+	return 1 / (sqrt(2.0 * M_PI))*exp(-x*x / 2.0);
+}
 
 
-	return value;
+//cumulative distribution of the standard normal distribution in closed form through the complementary error function
+double BlackScholesOptionPricer::N(double d) {
+    return 0.5 * erfc(-d * M_SQRT1_2);
 }
\ No newline at end of file
@@ -1,6 +1,40 @@
 #ifndef BLACK_SCHOLES_OPTION_PRICER
 #define BLACK_SCHOLES_OPTION_PRICER
 
+#include <cstddef>
+
+//price and sensitivities of one option, time is in years and rates/volatility are in decimals
+struct BlackScholesGreeks {
+    double price;
+    double delta;       //dV/dS
+    double gamma;       //d2V/dS2
+    double vega;        //dV/dvolatility
+    double theta;       //dV/dt, calendar time decay per year
+    double rho;         //dV/dinterestRate
+    double epsilon;     //dV/ddividend
+    double vanna;       //d2V/dSdvolatility
+    double volga;       //d2V/dvolatility2
+    double charm;       //ddelta/dt
+};
+
+//inputs and derived terms shared by every strike of one underlying and expiry
+struct BlackScholesExpiryTerms {
+    BlackScholesExpiryTerms() {}
+    BlackScholesExpiryTerms(double stockPrice, double interestRate, double dividend, double expiryTime);
+
+    //only the spot dependent terms are refreshed, the discount factors and sqrt(T) are kept
+    void setStockPrice(double stockPrice);
+
+    double stockPrice;
+    double interestRate;
+    double dividend;
+    double expiryTime;          // in years
+    double sqrtT;
+    double dividendDiscount;    //exp(-dividend*T)
+    double rateDiscount;        //exp(-interestRate*T)
+    double discountedStock;     //stockPrice*exp(-dividend*T)
+    double logForward;          //log(stockPrice) + (interestRate - dividend)*T
+};
 
 class BlackScholesOptionPricer {
 
@@ -9,13 +43,36 @@ public:
     double callPrice();
     double putPrice();
 
-private:
-    double getNd1();
-    double getNd2();
+    //price plus all first and second order greeks, d1/d2/N(d)/pdf are evaluated once
+    BlackScholesGreeks callGreeks();
+    BlackScholesGreeks putGreeks();
+    void greeks(BlackScholesGreeks& call, BlackScholesGreeks& put);
+
+    //call and put greeks for one set of inputs without constructing a pricer
+    static void greeks(double stockPrice, double strikePrice, double interestRate, double dividend, double volatility, double expiryTime,
+        BlackScholesGreeks& call, BlackScholesGreeks& put);
+
+    //call and put greeks for one strike of an expiry whose shared terms are already computed
+    static void greeks(const BlackScholesExpiryTerms& terms, double strikePrice, double logStrike, double volatility,
+        BlackScholesGreeks& call, BlackScholesGreeks& put);
+
+    //greeks for a whole book given as structure-of-arrays inputs
+    static void greeksBatch(std::size_t n, const double* stockPrice, const double* strikePrice, const double* interestRate,
+        const double* dividend, const double* volatility, const double* expiryTime, BlackScholesGreeks* call, BlackScholesGreeks* put);
+
+    //price n options given as structure-of-arrays, filling the call and put arrays in one pass
+    //the loop is branch free so it vectorizes (AVX2/AVX-512) when built with e.g. -O3 -mavx2 -fopenmp-simd -ffast-math
+    static void priceBatch(std::size_t n, const double* stockPrice, const double* strikePrice, const double* interestRate,
+        const double* dividend, const double* volatility, const double* expiryTime, double* callPrice, double* putPrice);
+
     //pdf of standard normal distribution
-    double f(double x);	
-    //Simpson's rule of finding integral(cumulative distribution of the standard normal distribution in this case)  
-    double N(double d);	
+    static double f(double x);
+    //cumulative distribution of the standard normal distribution, N(d) = erfc(-d/sqrt(2))/2
+    //erfc keeps full double precision (relative error < 1e-15) including the far left tail
+    static double N(double d);
+
+private:
+    void getD1D2(double& d1, double& d2);
 
 private:
     double stockPrice;
@@ -26,4 +83,4 @@ private:
     double expiryTime;            // in years
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,143 @@
+#include "ImpliedVolatility.hpp"
+#include <cmath>
+#include <math.h>
+#include <limits>
+#include <algorithm>
+
+//same closed forms as BlackScholesOptionPricer::N and f, kept inline here so the lockstep loop can vectorize
+static inline double normalCdf(double d) {
+    return 0.5 * erfc(-d * M_SQRT1_2);
+}
+
+static inline double normalPdf(double x) {
+    return exp(-x * x / 2.0) / sqrt(2.0 * M_PI);
+}
+
+const std::size_t ImpliedVolatilitySolver::lanes;
+
+ImpliedVolatilitySolver::ImpliedVolatilitySolver(double tolerance, int maxIterations)
+    : tolerance(tolerance), maxIterations(maxIterations) {
+
+}
+
+double ImpliedVolatilitySolver::solve(double optionPrice, bool isCall, double stockPrice, double strikePrice, double interestRate, double dividend, double expiryTime, int& iterations) {
+    double volatility;
+    solveLanes(1, &optionPrice, &isCall, &stockPrice, &strikePrice, &interestRate, &dividend, &expiryTime, &volatility, &iterations);
+    return volatility;
+}
+
+std::size_t ImpliedVolatilitySolver::solveBatch(std::size_t n, const double* optionPrice, const bool* isCall, const double* stockPrice, const double* strikePrice,
+    const double* interestRate, const double* dividend, const double* expiryTime, double* volatility, int* iterations) {
+
+    std::size_t converged = 0;
+
+    for (std::size_t i = 0; i < n; i += lanes)
+    {
+        std::size_t count = std::min(lanes, n - i);
+        converged += solveLanes(count, optionPrice + i, isCall + i, stockPrice + i, strikePrice + i, interestRate + i, dividend + i, expiryTime + i,
+            volatility + i, iterations + i);
+    }
+
+    return converged;
+}
+
+//Everything is done on undiscounted prices in terms of the total volatility w = volatility * sqrt(T):
+//c(w) = F*N(d1) - K*N(d2), d1 = log(F/K)/w + w/2, d2 = d1 - w, dc/dw = F*pdf(d1), d2c/dw2 = dc/dw * d1*d2/w
+//Each lane works on its out-of-the-money side (theta = +1 call, -1 put) so the target keeps full precision,
+//in-the-money quotes are moved across with put-call parity and every lane still runs the same instructions
+std::size_t ImpliedVolatilitySolver::solveLanes(std::size_t count, const double* optionPrice, const bool* isCall, const double* stockPrice, const double* strikePrice,
+    const double* interestRate, const double* dividend, const double* expiryTime, double* volatility, int* iterations) {
+
+    double forward[lanes], strike[lanes], target[lanes], theta[lanes], sqrtT[lanes];
+    double w[lanes], lower[lanes], upper[lanes];
+    //masks and counters are 64 bit so they occupy the same lane width as the doubles
+    long long steps[lanes];
+    long long active[lanes];
+
+    const double maxTotalVolatility = 10.0;
+    std::size_t remaining = 0;
+
+    for (std::size_t i = 0; i < lanes; i++)
+    {
+        //pad the unused lanes with an at-the-money option so the lockstep loop stays well defined
+        std::size_t j = i < count ? i : 0;
+
+        double discount = exp(-interestRate[j] * expiryTime[j]);
+        forward[i] = stockPrice[j] * exp((interestRate[j] - dividend[j]) * expiryTime[j]);
+        strike[i] = strikePrice[j];
+        sqrtT[i] = sqrt(expiryTime[j]);
+        theta[i] = forward[i] < strike[i] ? 1.0 : -1.0;
+
+        //call - put = F - K
+        double undiscounted = optionPrice[j] / discount;
+        bool outOfTheMoney = isCall[j] == (theta[i] > 0);
+        target[i] = outOfTheMoney ? undiscounted : undiscounted + theta[i] * (forward[i] - strike[i]);
+
+        active[i] = i < count && target[i] > 0 && target[i] < (theta[i] > 0 ? forward[i] : strike[i]);
+        steps[i] = active[i] ? 0 : -1;
+        remaining += active[i] ? 1 : 0;
+
+        //Corrado-Miller initial guess on the call price, falling back to Brenner-Subrahmanyam when the discriminant goes negative
+        double call = theta[i] > 0 ? target[i] : target[i] + forward[i] - strike[i];
+        double excess = call - (forward[i] - strike[i]) / 2;
+        double discriminant = excess * excess - (forward[i] - strike[i]) * (forward[i] - strike[i]) / M_PI;
+        double guess = sqrt(2 * M_PI) / (forward[i] + strike[i]) * (excess + sqrt(std::max(discriminant, 0.0)));
+        if (!(guess > 0))
+            guess = sqrt(2 * M_PI) * call / forward[i];
+
+        lower[i] = 0;
+        upper[i] = maxTotalVolatility;
+        w[i] = std::min(std::max(guess, 1e-4), maxTotalVolatility / 2);
+    }
+
+    for (int iteration = 0; iteration < maxIterations && remaining > 0; iteration++)
+    {
+        //one Halley step on all lanes, finished lanes compute but keep their value
+#pragma omp simd
+        for (std::size_t i = 0; i < lanes; i++)
+        {
+            double d1 = log(forward[i] / strike[i]) / w[i] + w[i] / 2;
+            double d2 = d1 - w[i];
+            double price = theta[i] * (forward[i] * normalCdf(theta[i] * d1) - strike[i] * normalCdf(theta[i] * d2));
+            double vega = forward[i] * normalPdf(d1);
+            double volga = vega * d1 * d2 / w[i];
+
+            //Halley on log(price) - log(target), which stays close to linear for far out-of-the-money options
+            double diff = log(price / target[i]);
+            double slope = vega / price;
+            double curvature = volga / price - slope * slope;
+
+            //the price is increasing in w, so the sign of diff tells which side of the root we are on
+            double newLower = diff < 0 ? w[i] : lower[i];
+            double newUpper = diff > 0 ? w[i] : upper[i];
+
+            double step = 2 * diff * slope / (2 * slope * slope - diff * curvature);
+            double next = w[i] - step;
+            bool bracketed = next >= newLower && next <= newUpper;
+            next = bracketed ? next : (newLower + newUpper) / 2;
+
+            bool done = std::fabs(next - w[i]) < tolerance * sqrtT[i];
+
+            w[i] = active[i] ? next : w[i];
+            lower[i] = active[i] ? newLower : lower[i];
+            upper[i] = active[i] ? newUpper : upper[i];
+            steps[i] += active[i] ? 1 : 0;
+            active[i] = active[i] && !done;
+        }
+
+        remaining = 0;
+        for (std::size_t i = 0; i < lanes; i++)
+            remaining += active[i] ? 1 : 0;
+    }
+
+    std::size_t converged = 0;
+    for (std::size_t i = 0; i < count; i++)
+    {
+        bool solved = steps[i] >= 0 && !active[i];
+        volatility[i] = steps[i] >= 0 ? w[i] / sqrtT[i] : std::numeric_limits<double>::quiet_NaN();
+        iterations[i] = int(steps[i]);
+        converged += solved ? 1 : 0;
+    }
+
+    return converged;
+}
@@ -0,0 +1,35 @@
+#ifndef IMPLIED_VOLATILITY_HPP
+#define IMPLIED_VOLATILITY_HPP
+
+#include <cstddef>
+
+//Inverts BlackScholesOptionPricer's callPrice/putPrice for whole option chains
+//Every option starts from the Corrado-Miller approximation and takes Halley steps driven by the analytic vega,
+//kept inside a bisection bracket so a step can never leave the region where the price is monotone in volatility
+class ImpliedVolatilitySolver {
+
+public:
+    //number of options iterated in lockstep, a multiple of the AVX-512 double width
+    static const std::size_t lanes = 8;
+
+    ImpliedVolatilitySolver(double tolerance = 1e-10, int maxIterations = 32);
+
+    //solve one option, iterations receives the number of Halley steps taken (-1 if the price has no implied volatility)
+    double solve(double optionPrice, bool isCall, double stockPrice, double strikePrice, double interestRate, double dividend, double expiryTime, int& iterations);
+
+    //solve n options given as structure-of-arrays, returns how many converged
+    //options without an implied volatility (price outside the no-arbitrage bounds) get NaN and iterations = -1
+    std::size_t solveBatch(std::size_t n, const double* optionPrice, const bool* isCall, const double* stockPrice, const double* strikePrice,
+        const double* interestRate, const double* dividend, const double* expiryTime, double* volatility, int* iterations);
+
+private:
+    //solve up to `lanes` options, all lanes step together and a lane stops updating once its mask is cleared
+    std::size_t solveLanes(std::size_t count, const double* optionPrice, const bool* isCall, const double* stockPrice, const double* strikePrice,
+        const double* interestRate, const double* dividend, const double* expiryTime, double* volatility, int* iterations);
+
+private:
+    double tolerance;           //on the volatility
+    int maxIterations;
+};
+
+#endif
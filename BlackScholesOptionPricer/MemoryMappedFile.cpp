@@ -0,0 +1,130 @@
+#include "MemoryMappedFile.hpp"
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MemoryMappedFile::MemoryMappedFile(const std::string& path) : address(0), length(0) {
+    map(path, 0, false);
+}
+
+MemoryMappedFile::MemoryMappedFile(const std::string& path, std::size_t size) : address(0), length(0) {
+    map(path, size, true);
+}
+
+void* MemoryMappedFile::data() const {
+    return address;
+}
+
+std::size_t MemoryMappedFile::size() const {
+    return length;
+}
+
+#ifdef _WIN32
+
+void MemoryMappedFile::map(const std::string& path, std::size_t size, bool writable) {
+    file = CreateFileA(path.c_str(), writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ, FILE_SHARE_READ, NULL,
+        writable ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("can not open " + path);
+
+    if (writable)
+    {
+        length = size;
+    }
+    else
+    {
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize))
+        {
+            CloseHandle(file);
+            throw std::runtime_error("can not stat " + path);
+        }
+        length = std::size_t(fileSize.QuadPart);
+    }
+
+    mapping = NULL;
+    if (length == 0)
+        return;
+
+    DWORD high = DWORD((unsigned long long)length >> 32);
+    DWORD low = DWORD(length & 0xFFFFFFFFull);
+    mapping = CreateFileMappingA(file, NULL, writable ? PAGE_READWRITE : PAGE_READONLY, high, low, NULL);
+    if (mapping == NULL)
+    {
+        CloseHandle(file);
+        throw std::runtime_error("can not map " + path);
+    }
+
+    address = MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, length);
+    if (address == NULL)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        throw std::runtime_error("can not map " + path);
+    }
+}
+
+MemoryMappedFile::~MemoryMappedFile() {
+    if (address)
+        UnmapViewOfFile(address);
+    if (mapping)
+        CloseHandle(mapping);
+    CloseHandle(file);
+}
+
+#else
+
+void MemoryMappedFile::map(const std::string& path, std::size_t size, bool writable) {
+    file = open(path.c_str(), writable ? O_RDWR | O_CREAT | O_TRUNC : O_RDONLY, 0644);
+    if (file < 0)
+        throw std::runtime_error("can not open " + path);
+
+    if (writable)
+    {
+        if (ftruncate(file, off_t(size)) != 0)
+        {
+            close(file);
+            throw std::runtime_error("can not resize " + path);
+        }
+        length = size;
+    }
+    else
+    {
+        struct stat status;
+        if (fstat(file, &status) == -1)
+        {
+            close(file);
+            throw std::runtime_error("can not stat " + path);
+        }
+        length = std::size_t(status.st_size);
+    }
+
+    if (length == 0)
+        return;
+
+    address = mmap(0, length, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, file, 0);
+    if (address == MAP_FAILED)
+    {
+        address = 0;
+        close(file);
+        throw std::runtime_error("can not map " + path);
+    }
+
+    //records are streamed front to back exactly once
+    madvise(address, length, MADV_SEQUENTIAL);
+}
+
+MemoryMappedFile::~MemoryMappedFile() {
+    if (address)
+        munmap(address, length);
+    close(file);
+}
+
+#endif
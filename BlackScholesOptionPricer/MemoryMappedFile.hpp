@@ -0,0 +1,38 @@
+#ifndef MEMORY_MAPPED_FILE_HPP
+#define MEMORY_MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <string>
+
+//Maps a whole file into memory, read-only for inputs or read-write for a freshly sized output
+//Throws std::runtime_error when the file can not be opened or mapped
+class MemoryMappedFile {
+
+public:
+    //map an existing file read-only
+    explicit MemoryMappedFile(const std::string& path);
+    //create (or truncate) a file of the given size and map it read-write
+    MemoryMappedFile(const std::string& path, std::size_t size);
+    ~MemoryMappedFile();
+
+    void* data() const;
+    std::size_t size() const;
+
+private:
+    MemoryMappedFile(const MemoryMappedFile&);
+    MemoryMappedFile& operator=(const MemoryMappedFile&);
+
+    void map(const std::string& path, std::size_t size, bool writable);
+
+private:
+    void* address;
+    std::size_t length;
+#ifdef _WIN32
+    void* file;
+    void* mapping;
+#else
+    int file;
+#endif
+};
+
+#endif
@@ -0,0 +1,90 @@
+#include "OptionChain.hpp"
+#include <cmath>
+#include <math.h>
+
+OptionChain::OptionChain(double stockPrice, double interestRate, double dividend, double expiryTime)
+    : terms(stockPrice, interestRate, dividend, expiryTime) {
+
+}
+
+OptionChain::OptionChain(double stockPrice, double interestRate, double dividend, double expiryTime, const std::vector<double>& strikePrices)
+    : terms(stockPrice, interestRate, dividend, expiryTime) {
+
+    setStrikes(strikePrices);
+}
+
+void OptionChain::setStockPrice(double stockPrice) {
+    terms.setStockPrice(stockPrice);
+}
+
+void OptionChain::setStrikes(const std::vector<double>& strikes) {
+    strikePrices = strikes;
+    logStrikes.resize(strikes.size());
+    discountedStrikes.resize(strikes.size());
+
+    for (std::size_t i = 0; i < strikes.size(); i++)
+    {
+        logStrikes[i] = log(strikes[i]);
+        discountedStrikes[i] = strikes[i] * terms.rateDiscount;
+    }
+}
+
+std::size_t OptionChain::size() const {
+    return strikePrices.size();
+}
+
+const std::vector<double>& OptionChain::strikes() const {
+    return strikePrices;
+}
+
+const BlackScholesExpiryTerms& OptionChain::expiryTerms() const {
+    return terms;
+}
+
+void OptionChain::price(const double* volatility, double* callPrice, double* putPrice) const {
+    price(strikePrices.size(), logStrikes.data(), discountedStrikes.data(), volatility, callPrice, putPrice);
+}
+
+void OptionChain::greeks(const double* volatility, BlackScholesGreeks* call, BlackScholesGreeks* put) const {
+    for (std::size_t i = 0; i < strikePrices.size(); i++)
+    {
+        BlackScholesOptionPricer::greeks(terms, strikePrices[i], logStrikes[i], volatility[i], call[i], put[i]);
+    }
+}
+
+void OptionChain::price(std::size_t n, const double* strikePrice, const double* volatility, double* callPrice, double* putPrice) const {
+    std::vector<double> logStrike(n), discountedStrike(n);
+
+    for (std::size_t i = 0; i < n; i++)
+    {
+        logStrike[i] = log(strikePrice[i]);
+        discountedStrike[i] = strikePrice[i] * terms.rateDiscount;
+    }
+
+    price(n, logStrike.data(), discountedStrike.data(), volatility, callPrice, putPrice);
+}
+
+void OptionChain::greeks(std::size_t n, const double* strikePrice, const double* volatility, BlackScholesGreeks* call, BlackScholesGreeks* put) const {
+    for (std::size_t i = 0; i < n; i++)
+    {
+        BlackScholesOptionPricer::greeks(terms, strikePrice[i], log(strikePrice[i]), volatility[i], call[i], put[i]);
+    }
+}
+
+//only d1, d2 and the two erfc calls depend on the strike, the loop vectorizes like BlackScholesOptionPricer::priceBatch
+void OptionChain::price(std::size_t n, const double* logStrike, const double* discountedStrike, const double* volatility, double* callPrice, double* putPrice) const {
+    const double logForward = terms.logForward;
+    const double discountedStock = terms.discountedStock;
+    const double sqrtT = terms.sqrtT;
+
+#pragma omp simd
+    for (std::size_t i = 0; i < n; i++)
+    {
+        double volSqrtT = volatility[i] * sqrtT;
+        double d1 = (logForward - logStrike[i]) / volSqrtT + volSqrtT / 2;
+        double d2 = d1 - volSqrtT;
+
+        callPrice[i] = discountedStock * 0.5 * erfc(-d1 * M_SQRT1_2) - discountedStrike[i] * 0.5 * erfc(-d2 * M_SQRT1_2);
+        putPrice[i] = discountedStrike[i] * 0.5 * erfc(d2 * M_SQRT1_2) - discountedStock * 0.5 * erfc(d1 * M_SQRT1_2);
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef OPTION_CHAIN_HPP
+#define OPTION_CHAIN_HPP
+
+#include "BlackScholesOptionPricer.hpp"
+#include <cstddef>
+#include <vector>
+
+//Prices every strike of one underlying and expiry
+//S, r, q, T, exp(-rT), exp(-qT) and sqrt(T) are computed once for the whole chain, log(K) and K*exp(-rT) once per strike,
+//so a spot tick only refreshes the forward and then reprices the strike dependent part
+class OptionChain {
+
+public:
+    OptionChain(double stockPrice, double interestRate, double dividend, double expiryTime);
+    OptionChain(double stockPrice, double interestRate, double dividend, double expiryTime, const std::vector<double>& strikePrices);
+
+    //cheap update on a spot tick, the cached per-strike terms stay valid
+    void setStockPrice(double stockPrice);
+    void setStrikes(const std::vector<double>& strikePrices);
+
+    std::size_t size() const;
+    const std::vector<double>& strikes() const;
+    const BlackScholesExpiryTerms& expiryTerms() const;
+
+    //price the cached strikes, volatility has one entry per strike (the smile)
+    void price(const double* volatility, double* callPrice, double* putPrice) const;
+    void greeks(const double* volatility, BlackScholesGreeks* call, BlackScholesGreeks* put) const;
+
+    //price an arbitrary strike vector against the same expiry without caching it
+    void price(std::size_t n, const double* strikePrice, const double* volatility, double* callPrice, double* putPrice) const;
+    void greeks(std::size_t n, const double* strikePrice, const double* volatility, BlackScholesGreeks* call, BlackScholesGreeks* put) const;
+
+private:
+    //strike dependent kernel shared by both price overloads
+    void price(std::size_t n, const double* logStrike, const double* discountedStrike, const double* volatility, double* callPrice, double* putPrice) const;
+
+private:
+    BlackScholesExpiryTerms terms;
+    std::vector<double> strikePrices;
+    std::vector<double> logStrikes;
+    std::vector<double> discountedStrikes;     //K*exp(-rT)
+};
+
+#endif
@@ -0,0 +1,58 @@
+#include "PortfolioPricer.hpp"
+#include "BlackScholesOptionPricer.hpp"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+PortfolioPricer::PortfolioPricer(unsigned threads, std::size_t blockSize) : threadCount(threads), blockSize(blockSize) {
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    if (this->blockSize == 0)
+        this->blockSize = 1;
+}
+
+unsigned PortfolioPricer::threads() const {
+    return threadCount;
+}
+
+void PortfolioPricer::price(const OptionContract* contracts, OptionValuation* valuations, std::size_t n) const {
+    std::atomic<std::size_t> next(0);
+
+    //each worker keeps claiming the next block until the book is done, so slow pages or cores do not hold up the others
+    auto worker = [&]() {
+        for (std::size_t begin = next.fetch_add(blockSize); begin < n; begin = next.fetch_add(blockSize))
+        {
+            priceRange(contracts, valuations, begin, std::min(begin + blockSize, n));
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < threadCount; i++)
+        pool.push_back(std::thread(worker));
+
+    worker();
+
+    for (auto it = pool.begin(); it != pool.end(); ++it)
+        it->join();
+}
+
+void PortfolioPricer::priceRange(const OptionContract* contracts, OptionValuation* valuations, std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; i++)
+    {
+        const OptionContract& contract = contracts[i];
+        BlackScholesGreeks call, put;
+
+        BlackScholesOptionPricer::greeks(contract.stockPrice, contract.strikePrice, contract.interestRate, contract.dividend,
+            contract.volatility, contract.expiryTime, call, put);
+
+        const BlackScholesGreeks& greeks = contract.isCall ? call : put;
+        OptionValuation& valuation = valuations[i];
+        valuation.price = greeks.price;
+        valuation.delta = greeks.delta;
+        valuation.gamma = greeks.gamma;
+        valuation.vega = greeks.vega;
+        valuation.theta = greeks.theta;
+        valuation.rho = greeks.rho;
+    }
+}
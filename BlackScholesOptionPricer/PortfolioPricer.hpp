@@ -0,0 +1,49 @@
+#ifndef PORTFOLIO_PRICER_HPP
+#define PORTFOLIO_PRICER_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+//one contract of a binary book file, fixed 64 byte records (one cache line) in native byte order
+struct OptionContract {
+    double stockPrice;
+    double strikePrice;
+    double interestRate;
+    double dividend;
+    double volatility;
+    double expiryTime;          // in years
+    std::int64_t isCall;        // 1 = call, 0 = put
+    std::int64_t reserved;      // padding, keep 0
+};
+
+//one record of the output file, same order as the input book
+struct OptionValuation {
+    double price;
+    double delta;
+    double gamma;
+    double vega;
+    double theta;
+    double rho;
+};
+
+//Prices a book of contracts in place: records are read straight from the input and greeks written straight to the output,
+//so both can be memory mapped files. Blocks of contracts are handed out to the worker threads on demand.
+class PortfolioPricer {
+
+public:
+    //threads = 0 uses every hardware thread
+    explicit PortfolioPricer(unsigned threads = 0, std::size_t blockSize = 4096);
+
+    void price(const OptionContract* contracts, OptionValuation* valuations, std::size_t n) const;
+
+    unsigned threads() const;
+
+private:
+    static void priceRange(const OptionContract* contracts, OptionValuation* valuations, std::size_t begin, std::size_t end);
+
+private:
+    unsigned threadCount;
+    std::size_t blockSize;
+};
+
+#endif
@@ -0,0 +1,73 @@
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include "MemoryMappedFile.hpp"
+#include "PortfolioPricer.hpp"
+
+// Price a book of options stored as fixed OptionContract records and write one OptionValuation record per contract
+//
+// portfolio <book.bin> <valuations.bin> [threads]     price a book
+// portfolio --generate <book.bin> <count>             write a random book for testing
+
+void generate(const std::string& path, std::size_t count) {
+    MemoryMappedFile book(path, count * sizeof(OptionContract));
+    OptionContract* contracts = static_cast<OptionContract*>(book.data());
+
+    std::mt19937_64 engine(42);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    for (std::size_t i = 0; i < count; i++)
+    {
+        contracts[i].stockPrice = 100;
+        contracts[i].strikePrice = 50 + 100 * uniform(engine);
+        contracts[i].interestRate = 0.05 * uniform(engine);
+        contracts[i].dividend = 0.03 * uniform(engine);
+        contracts[i].volatility = 0.1 + 0.5 * uniform(engine);
+        contracts[i].expiryTime = 0.05 + 2 * uniform(engine);
+        contracts[i].isCall = i % 2;
+        contracts[i].reserved = 0;
+    }
+
+    std::cout << "Generated " << count << " contracts in " << path << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+
+    try {
+        if (argc == 4 && std::string(argv[1]) == "--generate") {
+            generate(argv[2], std::strtoull(argv[3], 0, 10));
+            return 0;
+        }
+
+        if (argc < 3) {
+            std::cerr << "Usage: portfolio <book.bin> <valuations.bin> [threads]" << std::endl;
+            std::cerr << "       portfolio --generate <book.bin> <count>" << std::endl;
+            return 1;
+        }
+
+        MemoryMappedFile book(argv[1]);
+        if (book.size() % sizeof(OptionContract) != 0)
+            throw std::runtime_error("book size is not a multiple of the record size");
+
+        std::size_t count = book.size() / sizeof(OptionContract);
+        MemoryMappedFile valuations(argv[2], count * sizeof(OptionValuation));
+
+        PortfolioPricer pricer(argc > 3 ? unsigned(std::atoi(argv[3])) : 0);
+
+        std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+        pricer.price(static_cast<const OptionContract*>(book.data()), static_cast<OptionValuation*>(valuations.data()), count);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        std::cout << "Priced " << count << " options on " << pricer.threads() << " threads in " << elapsed.count() << "s" << std::endl;
+        std::cout << "Throughput = " << (elapsed.count() > 0 ? count / elapsed.count() : 0) << " options/second" << std::endl;
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
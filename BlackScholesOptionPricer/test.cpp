@@ -1,5 +1,8 @@
 #include <iostream>
 #include "BlackScholesOptionPricer.hpp"
+#include "ImpliedVolatility.hpp"
+#include "OptionChain.hpp"
+#include <vector>
 
 
 
@@ -13,6 +16,50 @@ int main() {
     std::cout << "Call Price = " << callPrice << std::endl;
     std::cout << "Put Price = " << putPrice << std::endl;
 
+    // the same option priced through the batch API, next to two other strikes
+    double stockPrices[] = { 60, 60, 60 };
+    double strikePrices[] = { 55, 60, 65 };
+    double interestRates[] = { 0.08, 0.08, 0.08 };
+    double dividends[] = { 0, 0, 0 };
+    double volatilities[] = { 0.3, 0.3, 0.3 };
+    double expiryTimes[] = { 0.25, 0.25, 0.25 };
+    double callPrices[3];
+    double putPrices[3];
 
+    BlackScholesOptionPricer::priceBatch(3, stockPrices, strikePrices, interestRates, dividends, volatilities, expiryTimes, callPrices, putPrices);
 
+    for (int i = 0; i < 3; i++) {
+        std::cout << "K = " << strikePrices[i] << " Call Price = " << callPrices[i] << " Put Price = " << putPrices[i] << std::endl;
+    }
+
+    BlackScholesGreeks callGreeks, putGreeks;
+    blacksScholesOptionPricer.greeks(callGreeks, putGreeks);
+
+    std::cout << "Call Delta = " << callGreeks.delta << " Gamma = " << callGreeks.gamma << " Vega = " << callGreeks.vega
+        << " Theta = " << callGreeks.theta << " Rho = " << callGreeks.rho << std::endl;
+    std::cout << "Put Delta = " << putGreeks.delta << " Gamma = " << putGreeks.gamma << " Vega = " << putGreeks.vega
+        << " Theta = " << putGreeks.theta << " Rho = " << putGreeks.rho << std::endl;
+
+    // back out the volatility of the chain priced above, calls and puts alike
+    bool isCall[] = { true, true, false };
+    double quotes[] = { callPrices[0], callPrices[1], putPrices[2] };
+    double impliedVolatilities[3];
+    int iterations[3];
+
+    ImpliedVolatilitySolver impliedVolatilitySolver;
+    impliedVolatilitySolver.solveBatch(3, quotes, isCall, stockPrices, strikePrices, interestRates, dividends, expiryTimes, impliedVolatilities, iterations);
+
+    for (int i = 0; i < 3; i++) {
+        std::cout << "K = " << strikePrices[i] << " Implied Volatility = " << impliedVolatilities[i] << " (" << iterations[i] << " iterations)" << std::endl;
+    }
+
+    // the whole chain shares S, r, q and T, a spot tick only reprices the strike dependent part
+    OptionChain chain(60, 0.08, 0, 0.25, std::vector<double>(strikePrices, strikePrices + 3));
+
+    chain.setStockPrice(61);
+    chain.price(volatilities, callPrices, putPrices);
+
+    for (int i = 0; i < 3; i++) {
+        std::cout << "S = 61 K = " << strikePrices[i] << " Call Price = " << callPrices[i] << " Put Price = " << putPrices[i] << std::endl;
+    }
 }
\ No newline at end of file
@@ -0,0 +1,158 @@
+#include "BatchYieldSolver.hpp"
+#include "ComputeYieldNewtonMethod.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+BondUniverse::BondUniverse() : offsets(1, 0) {
+
+}
+
+void BondUniverse::add(const ComputeYieldNewtonMethod& bond) {
+    add(bond.cashflowTimes().data(), bond.cashflowAmounts().data(), bond.cashflowTimes().size(), bond.getPrice());
+}
+
+void BondUniverse::add(const double* cashflowTimes, const double* cashflowAmounts, std::size_t count, double price) {
+    times.insert(times.end(), cashflowTimes, cashflowTimes + count);
+    amounts.insert(amounts.end(), cashflowAmounts, cashflowAmounts + count);
+    offsets.push_back(times.size());
+    prices.push_back(price);
+}
+
+std::size_t BondUniverse::size() const {
+    return prices.size();
+}
+
+const std::size_t BatchYieldSolver::lanes;
+
+BatchYieldSolver::BatchYieldSolver(double tolerance, int maxIterations, unsigned threads)
+    : tolerance(tolerance), maxIterations(maxIterations), threadCount(threads) {
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+}
+
+std::size_t BatchYieldSolver::solve(const BondUniverse& bonds, double x0, double* yield, double* duration, double* convexity, int* iterations) const {
+    std::size_t n = bonds.size();
+    std::vector<int> steps(iterations ? 0 : n);
+    if (!iterations)
+        iterations = steps.data();
+
+    //bonds with the same number of cashflows share a group so little of each padded block is wasted
+    std::vector<std::size_t> order(n);
+    for (std::size_t i = 0; i < n; i++)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        return bonds.offsets[a + 1] - bonds.offsets[a] < bonds.offsets[b + 1] - bonds.offsets[b];
+    });
+
+    std::atomic<std::size_t> next(0);
+    std::atomic<std::size_t> converged(0);
+
+    auto worker = [&]() {
+        std::size_t solved = 0;
+        for (std::size_t begin = next.fetch_add(lanes); begin < n; begin = next.fetch_add(lanes))
+        {
+            solved += solveLanes(bonds, order.data() + begin, std::min(lanes, n - begin), x0, yield, duration, convexity, iterations);
+        }
+        converged += solved;
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < threadCount; i++)
+        pool.push_back(std::thread(worker));
+
+    worker();
+
+    for (auto it = pool.begin(); it != pool.end(); ++it)
+        it->join();
+
+    return converged;
+}
+
+std::size_t BatchYieldSolver::solveLanes(const BondUniverse& bonds, const std::size_t* index, std::size_t count, double x0,
+    double* yield, double* duration, double* convexity, int* iterations) const {
+
+    //transpose the group into cashflow-major blocks, shorter bonds are padded with zero amounts
+    std::size_t cashflows = 0;
+    for (std::size_t i = 0; i < count; i++)
+        cashflows = std::max(cashflows, bonds.offsets[index[i] + 1] - bonds.offsets[index[i]]);
+
+    std::vector<double> times(cashflows * lanes, 0.0), amounts(cashflows * lanes, 0.0);
+    double price[lanes], x[lanes], value[lanes], first[lanes], second[lanes];
+    //64 bit masks and counters keep the same lane width as the doubles
+    long long active[lanes], steps[lanes];
+
+    for (std::size_t i = 0; i < lanes; i++)
+    {
+        bool used = i < count;
+        std::size_t bond = used ? index[i] : index[0];
+        for (std::size_t k = bonds.offsets[bond]; used && k < bonds.offsets[bond + 1]; k++)
+        {
+            times[(k - bonds.offsets[bond]) * lanes + i] = bonds.times[k];
+            amounts[(k - bonds.offsets[bond]) * lanes + i] = bonds.amounts[k];
+        }
+        price[i] = used ? bonds.prices[bond] : 1.0;
+        x[i] = x0;
+        active[i] = used;
+        steps[i] = 0;
+    }
+
+    //value, first and second derivative of sum(amount*exp(-x*t)) - price on every lane
+    auto evaluate = [&]() {
+        for (std::size_t i = 0; i < lanes; i++)
+        {
+            value[i] = 0;
+            first[i] = 0;
+            second[i] = 0;
+        }
+        for (std::size_t k = 0; k < cashflows; k++)
+        {
+            const double* t = &times[k * lanes];
+            const double* a = &amounts[k * lanes];
+#pragma omp simd
+            for (std::size_t i = 0; i < lanes; i++)
+            {
+                double discounted = a[i] * std::exp(-x[i] * t[i]);
+                value[i] += discounted;
+                first[i] += t[i] * discounted;
+                second[i] += t[i] * t[i] * discounted;
+            }
+        }
+    };
+
+    std::size_t remaining = count;
+    for (int iteration = 0; iteration < maxIterations && remaining > 0; iteration++)
+    {
+        evaluate();
+
+        remaining = 0;
+#pragma omp simd
+        for (std::size_t i = 0; i < lanes; i++)
+        {
+            //f' = -first, so the Newton step x - f/f' becomes x + (value - price)/first
+            double step = (value[i] - price[i]) / first[i];
+            bool done = std::fabs(step) <= tolerance;
+            x[i] = active[i] ? x[i] + step : x[i];
+            steps[i] += active[i] ? 1 : 0;
+            active[i] = active[i] && !done;
+        }
+        for (std::size_t i = 0; i < lanes; i++)
+            remaining += active[i] ? 1 : 0;
+    }
+
+    //duration and convexity at the solved yields
+    evaluate();
+
+    std::size_t converged = 0;
+    for (std::size_t i = 0; i < count; i++)
+    {
+        yield[index[i]] = x[i];
+        duration[index[i]] = first[i] / price[i];
+        convexity[index[i]] = second[i] / price[i];
+        iterations[index[i]] = int(steps[i]);
+        converged += active[i] ? 0 : 1;
+    }
+
+    return converged;
+}
@@ -0,0 +1,50 @@
+#ifndef BATCH_YIELD_SOLVER_HPP
+#define BATCH_YIELD_SOLVER_HPP
+
+#include <cstddef>
+#include <vector>
+
+class ComputeYieldNewtonMethod;
+
+//A flat universe of bonds: bond i owns the cashflows [offsets[i], offsets[i+1]) of times/amounts
+struct BondUniverse {
+    BondUniverse();
+
+    void add(const ComputeYieldNewtonMethod& bond);
+    void add(const double* cashflowTimes, const double* cashflowAmounts, std::size_t count, double price);
+
+    std::size_t size() const;
+
+    std::vector<std::size_t> offsets;
+    std::vector<double> times;          //in years
+    std::vector<double> amounts;
+    std::vector<double> prices;
+};
+
+//Yield, duration and convexity for a whole bond universe
+//Bonds are grouped by number of cashflows, each group of `lanes` bonds is transposed into a padded block and
+//Newton's method runs on all lanes in lockstep with a per-lane convergence mask. Groups are spread over a thread pool.
+class BatchYieldSolver {
+
+public:
+    //bonds solved together, a multiple of the AVX-512 double width
+    static const std::size_t lanes = 8;
+
+    //threads = 0 uses every hardware thread
+    BatchYieldSolver(double tolerance = 1e-10, int maxIterations = 50, unsigned threads = 0);
+
+    //returns how many bonds converged, iterations may be null
+    std::size_t solve(const BondUniverse& bonds, double x0, double* yield, double* duration, double* convexity, int* iterations = 0) const;
+
+private:
+    //solve the bonds listed in index (at most `lanes`), results are scattered back through index
+    std::size_t solveLanes(const BondUniverse& bonds, const std::size_t* index, std::size_t count, double x0,
+        double* yield, double* duration, double* convexity, int* iterations) const;
+
+private:
+    double tolerance;
+    int maxIterations;
+    unsigned threadCount;
+};
+
+#endif
@@ -3,7 +3,8 @@
 #include <cmath>
 
 ComputeYieldNewtonMethod::ComputeYieldNewtonMethod(int monthToExpiry, int couponInterval, double couponRate, double faceValue, double price) :
-    monthToExpiry(monthToExpiry), couponInterval(couponInterval), couponRate(couponRate), faceValue(faceValue), price(price) {
+    monthToExpiry(monthToExpiry), couponInterval(couponInterval), couponRate(couponRate), faceValue(faceValue), price(price),
+    hasLastYield(false), lastYield(0), lastIterations(0) {
 
     int offset = 1;
     if (monthToExpiry % couponInterval == 0)
@@ -12,6 +13,21 @@ ComputeYieldNewtonMethod::ComputeYieldNewtonMethod(int monthToExpiry, int coupon
     couponNumber = monthToExpiry / couponInterval + offset;
 
     coupon = faceValue*couponRate * (couponInterval / 12.0);
+
+    for (int i = 1; i <= couponNumber; i++)
+    {
+        times.push_back((monthToExpiry - (couponNumber - i)*couponInterval) / 12.0);
+        amounts.push_back(coupon);
+    }
+
+    //the face value is paid at expiry, with the last coupon when there is one
+    if (couponNumber > 0)
+        amounts.back() += faceValue;
+    else
+    {
+        times.push_back(monthToExpiry / 12.0);
+        amounts.push_back(faceValue);
+    }
 }
 
 double ComputeYieldNewtonMethod::getYield(double x0) {
@@ -19,74 +35,158 @@ double ComputeYieldNewtonMethod::getYield(double x0) {
 }
 
 double ComputeYieldNewtonMethod::getDuration(double x0) {
-    double xnew = newtonMethod(x0);
-    return -1.0 / price*(df(xnew));
+    return std::get<1>(getYieldDurationConvexity(x0));
 }
 
 double ComputeYieldNewtonMethod::getConvexity(double x0) {
-    double xnew = newtonMethod(x0);
-    return 1.0 / price*(ddf(xnew));
+    return std::get<2>(getYieldDurationConvexity(x0));
 }
 
 std::tuple<double, double, double> ComputeYieldNewtonMethod::getYieldDurationConvexity(double x0) {
     double xnew = newtonMethod(x0);
-    return std::make_tuple(xnew, -1.0 / price*(df(xnew)), 1.0 / price*(ddf(xnew)));
+
+    double value, df, ddf;
+    evaluate(xnew, value, df, ddf);
+
+    return std::make_tuple(xnew, -1.0 / price*(df), 1.0 / price*(ddf));
 
 }
 
-double ComputeYieldNewtonMethod::newtonMethod(double x0) {
-    double xnew = x0;
-    double xold = x0 - 1;
-    double tolConsec = pow(10, -6);
-    while (abs(xnew - xold) > tolConsec)
-    {
-        xold = xnew;
-        xnew = xold - f(xold) / df(xold);
-    }
-    return xnew;
+const std::vector<double>& ComputeYieldNewtonMethod::cashflowTimes() const {
+    return times;
 }
 
-//f(x),bond value function
-double ComputeYieldNewtonMethod::f(double x)
-{
-    double total = 0;;
-    for (int i = 1; i <= couponNumber; i++)
+const std::vector<double>& ComputeYieldNewtonMethod::cashflowAmounts() const {
+    return amounts;
+}
+
+double ComputeYieldNewtonMethod::getPrice() const {
+    return price;
+}
+
+double ComputeYieldNewtonMethod::updatePrice(double newPrice) {
+    price = newPrice;
+
+    //cold start from the coupon rate, afterwards from the last solution which is usually 1-2 steps away
+    double x0 = hasLastYield ? lastYield : couponRate;
+    double x;
+    int iterations;
+
+    if (!cappedNewtonMethod(x0, x, iterations))
     {
-        total += coupon*exp(-x*(monthToExpiry - (couponNumber - i)*couponInterval) / 12.0);
+        int bracketIterations;
+        x = bracketedMethod(x0, bracketIterations);
+        iterations += bracketIterations;
     }
 
-    total += (faceValue)*exp(-x*(monthToExpiry) / 12.0);
+    hasLastYield = true;
+    lastYield = x;
+    lastIterations = iterations;
+    return x;
+}
 
-    return total - price;
+double ComputeYieldNewtonMethod::getLastYield() const {
+    return lastYield;
 }
 
+int ComputeYieldNewtonMethod::getLastIterations() const {
+    return lastIterations;
+}
 
-//first derivative of f(x)
-double ComputeYieldNewtonMethod::df(double x)
-{
-    double total = 0;
+bool ComputeYieldNewtonMethod::cappedNewtonMethod(double x0, double& x, int& iterations) {
+    double tolConsec = pow(10, -10);
+    double value, df, ddf;
+
+    x = x0;
+    for (iterations = 1; iterations <= maxStreamingIterations; iterations++)
+    {
+        //the fused evaluation gives f'' for free, so take Halley steps (cubic convergence)
+        evaluate(x, value, df, ddf);
+        double step = 2 * value * df / (2 * df * df - value * ddf);
+        x -= step;
+
+        if (!std::isfinite(x))
+            return false;
+        if (std::abs(step) <= tolConsec)
+            return true;
+    }
+    iterations = maxStreamingIterations;
+    return false;
+}
+
+double ComputeYieldNewtonMethod::bracketedMethod(double x0, int& iterations) {
+    double tolConsec = pow(10, -10);
+    double value, df, ddf;
+    iterations = 0;
 
-    for (int i = 1; i <= couponInterval; i++)
+    //the bond value falls as the yield rises, so f(lower) > 0 > f(upper) brackets the root
+    double start = std::isfinite(x0) ? x0 : 0;
+    double lower = start, upper = start, width = 0.01;
+    for (int i = 0; i < 64; i++)
     {
-        total += (monthToExpiry - (couponNumber - i)*couponInterval) / 12.0 * coupon*exp(-x*(monthToExpiry - (couponNumber - i)*couponInterval) / 12.0);
+        double fLower, fUpper;
+        evaluate(lower, fLower, df, ddf);
+        evaluate(upper, fUpper, df, ddf);
+        if (fLower >= 0 && fUpper <= 0)
+            break;
+        if (fLower < 0)
+            lower -= width;
+        if (fUpper > 0)
+            upper += width;
+        width *= 2;
     }
 
-    total += (monthToExpiry / 12.0)*(faceValue)*exp(-x*(monthToExpiry) / 12.0);
+    //Newton steps that would leave the bracket are replaced by bisection
+    double x = (lower + upper) / 2;
+    while (upper - lower > tolConsec && iterations < 200)
+    {
+        iterations++;
+        evaluate(x, value, df, ddf);
+        if (value > 0)
+            lower = x;
+        else
+            upper = x;
+
+        double next = x - value / df;
+        if (!(next > lower && next < upper))
+            next = (lower + upper) / 2;
+        if (std::abs(next - x) <= tolConsec)
+            return next;
+        x = next;
+    }
+    return x;
+}
 
-    return (-total);
+double ComputeYieldNewtonMethod::newtonMethod(double x0) {
+    double xnew = x0;
+    double xold = x0 - 1;
+    double tolConsec = pow(10, -6);
+    double value, df, ddf;
+    while (std::abs(xnew - xold) > tolConsec)
+    {
+        xold = xnew;
+        evaluate(xold, value, df, ddf);
+        xnew = xold - value / df;
+    }
+    return xnew;
 }
 
-//second derivative of f(x)
-double ComputeYieldNewtonMethod::ddf(double x)
+//f(x) = sum(amount*exp(-x*t)) - price, f'(x) = -sum(t*amount*exp(-x*t)), f''(x) = sum(t^2*amount*exp(-x*t))
+void ComputeYieldNewtonMethod::evaluate(double x, double& value, double& firstDerivative, double& secondDerivative)
 {
     double total = 0;
+    double first = 0;
+    double second = 0;
 
-    for (int i = 1; i <= couponInterval; i++)
+    for (std::size_t i = 0; i < times.size(); i++)
     {
-        total += pow(((monthToExpiry - (couponNumber - i)*couponInterval) / 12.0), 2) * coupon*exp(-x*(monthToExpiry - (couponNumber - i)*couponInterval) / 12.0);
+        double discounted = amounts[i] * exp(-x*times[i]);
+        total += discounted;
+        first += times[i] * discounted;
+        second += times[i] * times[i] * discounted;
     }
 
-    total += pow((monthToExpiry / 12.0), 2)*(faceValue)*exp(-x*(monthToExpiry) / 12.0);
-
-    return total;
+    value = total - price;
+    firstDerivative = -first;
+    secondDerivative = second;
 }
\ No newline at end of file
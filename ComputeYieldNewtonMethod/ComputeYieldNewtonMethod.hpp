@@ -2,6 +2,7 @@
 #define COMPUTE_YIELD_NEWTON_METHOD_HPP
 
 #include <tuple>
+#include <vector>
 
 class ComputeYieldNewtonMethod {
 
@@ -16,17 +17,32 @@ public:
 
     std::tuple<double, double, double> getYieldDurationConvexity(double x0);
 
+    //cached cashflow schedule (times in years, face value included in the last amount) and the price it is solved against
+    const std::vector<double>& cashflowTimes() const;
+    const std::vector<double>& cashflowAmounts() const;
+    double getPrice() const;
+
+    //streaming mode: take a new price tick and re-solve starting from the previous yield
+    //Halley/Newton is capped at maxStreamingIterations, if it fails a bracketed Newton/bisection solve takes over
+    double updatePrice(double newPrice);
+
+    //last yield solved in streaming mode and the iterations it took (Newton plus any bracketed fallback)
+    double getLastYield() const;
+    int getLastIterations() const;
+
+    static const int maxStreamingIterations = 8;
+
 private:
     double newtonMethod(double x0);
 
-    //f(x),bond value function
-    double f(double x);
+    //Halley's method from x0 with at most maxStreamingIterations steps, returns false if it did not converge
+    bool cappedNewtonMethod(double x0, double& x, int& iterations);
 
-    //first derivative of f(x)
-    double df(double x);
+    //safeguarded Newton inside an expanding bracket around x0, always terminates
+    double bracketedMethod(double x0, int& iterations);
 
-    //second derivative of f(x)
-    double ddf(double x);
+    //f(x) = bond value - price and its first and second derivatives, from one pass over the cached discount factors
+    void evaluate(double x, double& value, double& firstDerivative, double& secondDerivative);
 
 private:
     int couponInterval;		        //e.g. semiannual = 6, annual = 12
@@ -36,5 +52,14 @@ private:
     double coupon;
     double price;
     double faceValue;
+
+    //cashflow schedule built once in the constructor, the face value is folded into the last amount
+    std::vector<double> times;       //in years
+    std::vector<double> amounts;
+
+    //streaming state
+    bool hasLastYield;
+    double lastYield;
+    int lastIterations;
 };
 #endif
\ No newline at end of file
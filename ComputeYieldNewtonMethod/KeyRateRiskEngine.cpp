@@ -0,0 +1,194 @@
+#include "KeyRateRiskEngine.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+CurveScenario CurveScenario::parallel(const std::vector<double>& keyTenors, double shift) {
+    CurveScenario scenario;
+    scenario.shifts.assign(keyTenors.size(), shift);
+    return scenario;
+}
+
+CurveScenario CurveScenario::twist(const std::vector<double>& keyTenors, double shortShift, double longShift) {
+    CurveScenario scenario;
+    double span = keyTenors.back() - keyTenors.front();
+    for (std::size_t k = 0; k < keyTenors.size(); k++)
+    {
+        double position = span > 0 ? (keyTenors[k] - keyTenors.front()) / span : 0;
+        scenario.shifts.push_back(shortShift + (longShift - shortShift) * position);
+    }
+    return scenario;
+}
+
+KeyRateRiskEngine::KeyRateRiskEngine(const BondUniverse& bonds, const std::vector<double>& positions, const YieldCurve& curve,
+    const std::vector<double>& keyTenors, unsigned threads, std::size_t blockSize)
+    : bonds(bonds), positions(positions), tenors(keyTenors), threadCount(threads), blockSize(std::max<std::size_t>(blockSize, 1)) {
+
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    blocks = (bonds.size() + this->blockSize - 1) / this->blockSize;
+
+    //the key tenors form their own curve, a cashflow's key-rate weights are its interpolation weights on it
+    YieldCurve keyCurve(tenors, std::vector<double>(tenors.size(), 0.0));
+
+    std::size_t cashflows = bonds.times.size();
+    discounted.resize(cashflows);
+    firstKey.resize(cashflows);
+    firstWeight.resize(cashflows);
+    for (std::size_t j = 0; j < cashflows; j++)
+    {
+        std::size_t left, right;
+        double leftWeight;
+        keyCurve.interpolation(bonds.times[j], left, right, leftWeight);
+
+        discounted[j] = bonds.amounts[j] * curve.discount(bonds.times[j]);
+        firstKey[j] = left;
+        firstWeight[j] = left == right ? 1.0 : leftWeight;
+    }
+}
+
+const std::vector<double>& KeyRateRiskEngine::keyTenors() const {
+    return tenors;
+}
+
+template<class Work>
+void KeyRateRiskEngine::forEachBlock(std::size_t tasks, Work work) const {
+    std::atomic<std::size_t> next(0);
+
+    auto worker = [&]() {
+        for (std::size_t task = next++; task < tasks; task = next++)
+            work(task);
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < threadCount && i < tasks; i++)
+        pool.push_back(std::thread(worker));
+
+    worker();
+
+    for (auto it = pool.begin(); it != pool.end(); ++it)
+        it->join();
+}
+
+double KeyRateRiskEngine::pairwiseSum(const double* x, std::size_t n, std::size_t stride) {
+    if (n == 0)
+        return 0;
+    if (n == 1)
+        return x[0];
+
+    std::size_t half = n / 2;
+    return pairwiseSum(x, half, stride) + pairwiseSum(x + half * stride, n - half, stride);
+}
+
+//value = sum(df*cf), key-rate duration k = sum(t*w_k*df*cf)/value, key-rate convexity k = sum(t^2*w_k^2*df*cf)/value
+void KeyRateRiskEngine::bondRisk(std::vector<double>& values, std::vector<double>& durations, std::vector<double>& convexities) const {
+    std::size_t n = bonds.size();
+    std::size_t keys = tenors.size();
+    values.assign(n, 0.0);
+    durations.assign(n * keys, 0.0);
+    convexities.assign(n * keys, 0.0);
+
+    forEachBlock(blocks, [&](std::size_t block) {
+        std::size_t end = std::min(n, (block + 1) * blockSize);
+        for (std::size_t i = block * blockSize; i < end; i++)
+        {
+            double value = 0;
+            double* duration = &durations[i * keys];
+            double* convexity = &convexities[i * keys];
+
+            for (std::size_t j = bonds.offsets[i]; j < bonds.offsets[i + 1]; j++)
+            {
+                double t = bonds.times[j];
+                double w = firstWeight[j];
+                std::size_t k = firstKey[j];
+
+                value += discounted[j];
+                duration[k] += t * w * discounted[j];
+                convexity[k] += t * t * w * w * discounted[j];
+                if (w < 1)
+                {
+                    duration[k + 1] += t * (1 - w) * discounted[j];
+                    convexity[k + 1] += t * t * (1 - w) * (1 - w) * discounted[j];
+                }
+            }
+
+            values[i] = value;
+            for (std::size_t k = 0; k < keys; k++)
+            {
+                duration[k] /= value;
+                convexity[k] /= value;
+            }
+        }
+    });
+}
+
+void KeyRateRiskEngine::portfolioRisk(double& value, std::vector<double>& durations, std::vector<double>& convexities) const {
+    std::vector<double> values, bondDurations, bondConvexities;
+    bondRisk(values, bondDurations, bondConvexities);
+
+    std::size_t n = bonds.size();
+    std::size_t keys = tenors.size();
+
+    //dollar quantities per block: value then key-rate durations then convexities
+    std::size_t width = 1 + 2 * keys;
+    std::vector<double> partial(blocks * width, 0.0);
+
+    forEachBlock(blocks, [&](std::size_t block) {
+        double* sums = &partial[block * width];
+        std::size_t end = std::min(n, (block + 1) * blockSize);
+        for (std::size_t i = block * blockSize; i < end; i++)
+        {
+            double held = positions[i] * values[i];
+            sums[0] += held;
+            for (std::size_t k = 0; k < keys; k++)
+            {
+                sums[1 + k] += held * bondDurations[i * keys + k];
+                sums[1 + keys + k] += held * bondConvexities[i * keys + k];
+            }
+        }
+    });
+
+    value = pairwiseSum(&partial[0], blocks, width);
+    durations.resize(keys);
+    convexities.resize(keys);
+    for (std::size_t k = 0; k < keys; k++)
+    {
+        durations[k] = pairwiseSum(&partial[1 + k], blocks, width) / value;
+        convexities[k] = pairwiseSum(&partial[1 + keys + k], blocks, width) / value;
+    }
+}
+
+std::vector<double> KeyRateRiskEngine::scenarioValues(const std::vector<CurveScenario>& scenarios) const {
+    std::size_t n = bonds.size();
+    std::size_t count = scenarios.size();
+    std::vector<double> partial(count * blocks, 0.0);
+
+    //one task per (scenario, block) so a few scenarios on a large book and many scenarios on a small book both spread out
+    forEachBlock(count * blocks, [&](std::size_t task) {
+        std::size_t s = task / blocks;
+        std::size_t block = task % blocks;
+        const std::vector<double>& shifts = scenarios[s].shifts;
+
+        double sum = 0;
+        std::size_t end = std::min(n, (block + 1) * blockSize);
+        for (std::size_t i = block * blockSize; i < end; i++)
+        {
+            double value = 0;
+            for (std::size_t j = bonds.offsets[i]; j < bonds.offsets[i + 1]; j++)
+            {
+                std::size_t k = firstKey[j];
+                double w = firstWeight[j];
+                double shift = w * shifts[k] + (w < 1 ? (1 - w) * shifts[k + 1] : 0.0);
+                value += discounted[j] * exp(-shift * bonds.times[j]);
+            }
+            sum += positions[i] * value;
+        }
+        partial[task] = sum;
+    });
+
+    std::vector<double> result(count);
+    for (std::size_t s = 0; s < count; s++)
+        result[s] = pairwiseSum(&partial[s * blocks], blocks, 1);
+    return result;
+}
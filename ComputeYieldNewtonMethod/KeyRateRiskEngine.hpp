@@ -0,0 +1,66 @@
+#ifndef KEY_RATE_RISK_ENGINE_HPP
+#define KEY_RATE_RISK_ENGINE_HPP
+
+#include <cstddef>
+#include <vector>
+#include "BatchYieldSolver.hpp"
+#include "YieldCurve.hpp"
+
+//A curve move given as zero rate shifts at the key tenors, interpolated with the same triangular weights as the key rates
+struct CurveScenario {
+    std::vector<double> shifts;
+
+    //every key rate moves by shift
+    static CurveScenario parallel(const std::vector<double>& keyTenors, double shift);
+    //shortShift at the first key tenor, longShift at the last, linear in tenor in between (steepener/flattener)
+    static CurveScenario twist(const std::vector<double>& keyTenors, double shortShift, double longShift);
+};
+
+//Key-rate durations/convexities and scenario revaluation for a bond portfolio on a zero curve
+//
+//Each cashflow's discount factor and key-rate weights are computed once in the constructor, so risk and every scenario
+//only rescale cached discount factors. Bonds are split into fixed blocks that a thread pool works through; each block's
+//partial sums are stored and then added up in block order with a pairwise reduction, so results are bit-identical
+//whatever the number of threads.
+class KeyRateRiskEngine {
+
+public:
+    //positions holds the quantity held of each bond, threads = 0 uses every hardware thread; bonds and positions are copied
+    KeyRateRiskEngine(const BondUniverse& bonds, const std::vector<double>& positions, const YieldCurve& curve,
+        const std::vector<double>& keyTenors, unsigned threads = 0, std::size_t blockSize = 256);
+
+    const std::vector<double>& keyTenors() const;
+
+    //per bond value, key-rate durations and key-rate convexities (bonds x key tenors, row major)
+    void bondRisk(std::vector<double>& values, std::vector<double>& durations, std::vector<double>& convexities) const;
+
+    //portfolio value and its value-weighted key-rate durations and convexities
+    void portfolioRisk(double& value, std::vector<double>& durations, std::vector<double>& convexities) const;
+
+    //portfolio value after each scenario
+    std::vector<double> scenarioValues(const std::vector<CurveScenario>& scenarios) const;
+
+private:
+    //run work(block) for every block of bonds on the thread pool
+    template<class Work>
+    void forEachBlock(std::size_t tasks, Work work) const;
+
+    //sum in a fixed order that does not depend on how the blocks were scheduled
+    static double pairwiseSum(const double* x, std::size_t n, std::size_t stride);
+
+private:
+    BondUniverse bonds;
+    std::vector<double> positions;
+    std::vector<double> tenors;
+
+    //per cashflow: the discounted amount on the base curve and the weights of the (at most two) key tenors it falls between
+    std::vector<double> discounted;
+    std::vector<std::size_t> firstKey;
+    std::vector<double> firstWeight;
+
+    unsigned threadCount;
+    std::size_t blockSize;
+    std::size_t blocks;
+};
+
+#endif
@@ -0,0 +1,58 @@
+#include "YieldCurve.hpp"
+#include <algorithm>
+#include <cmath>
+
+YieldCurve::YieldCurve() {
+
+}
+
+YieldCurve::YieldCurve(const std::vector<double>& nodeTimes, const std::vector<double>& zeroRates)
+    : times(nodeTimes), rates(zeroRates) {
+
+}
+
+double YieldCurve::zeroRate(double t) const {
+    std::size_t left, right;
+    double leftWeight;
+    interpolation(t, left, right, leftWeight);
+    return leftWeight * rates[left] + (1 - leftWeight) * rates[right];
+}
+
+double YieldCurve::discount(double t) const {
+    return exp(-zeroRate(t) * t);
+}
+
+void YieldCurve::interpolation(double t, std::size_t& left, std::size_t& right, double& leftWeight) const {
+    if (t <= times.front())
+    {
+        left = right = 0;
+        leftWeight = 1;
+        return;
+    }
+    if (t >= times.back())
+    {
+        left = right = times.size() - 1;
+        leftWeight = 1;
+        return;
+    }
+
+    right = std::size_t(std::upper_bound(times.begin(), times.end(), t) - times.begin());
+    left = right - 1;
+    leftWeight = (times[right] - t) / (times[right] - times[left]);
+}
+
+std::size_t YieldCurve::size() const {
+    return times.size();
+}
+
+const std::vector<double>& YieldCurve::nodeTimes() const {
+    return times;
+}
+
+const std::vector<double>& YieldCurve::zeroRates() const {
+    return rates;
+}
+
+void YieldCurve::setZeroRate(std::size_t node, double rate) {
+    rates[node] = rate;
+}
@@ -0,0 +1,31 @@
+#ifndef YIELD_CURVE_HPP
+#define YIELD_CURVE_HPP
+
+#include <cstddef>
+#include <vector>
+
+//Zero curve with continuously compounded zero rates at node times (in years)
+//Rates are linearly interpolated between nodes and held flat before the first and after the last node
+class YieldCurve {
+
+public:
+    YieldCurve();
+    YieldCurve(const std::vector<double>& nodeTimes, const std::vector<double>& zeroRates);
+
+    double zeroRate(double t) const;
+    double discount(double t) const;
+
+    //zeroRate(t) = leftWeight * rate[left] + (1 - leftWeight) * rate[right]
+    void interpolation(double t, std::size_t& left, std::size_t& right, double& leftWeight) const;
+
+    std::size_t size() const;
+    const std::vector<double>& nodeTimes() const;
+    const std::vector<double>& zeroRates() const;
+    void setZeroRate(std::size_t node, double rate);
+
+private:
+    std::vector<double> times;
+    std::vector<double> rates;
+};
+
+#endif
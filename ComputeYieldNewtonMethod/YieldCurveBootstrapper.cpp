@@ -0,0 +1,271 @@
+#include "YieldCurveBootstrapper.hpp"
+#include "ComputeYieldNewtonMethod.hpp"
+#include <algorithm>
+#include <cmath>
+
+YieldCurveBootstrapper::YieldCurveBootstrapper(double tolerance, int maxIterations)
+    : structureChanged(false), firstDirtyNode(0), solvedNodes(0), tolerance(tolerance), maxIterations(maxIterations) {
+
+}
+
+std::size_t YieldCurveBootstrapper::addBond(const ComputeYieldNewtonMethod& bond) {
+    bonds.add(bond);
+    structureChanged = true;
+    return bonds.size() - 1;
+}
+
+void YieldCurveBootstrapper::setPrice(std::size_t bond, double price) {
+    bonds.prices[bond] = price;
+    if (!structureChanged)
+        firstDirtyNode = std::min(firstDirtyNode, bondNode[bond]);
+}
+
+const YieldCurve& YieldCurveBootstrapper::curve() const {
+    return zeroCurve;
+}
+
+std::size_t YieldCurveBootstrapper::lastSolvedNodes() const {
+    return solvedNodes;
+}
+
+double YieldCurveBootstrapper::bondValue(std::size_t bond) const {
+    const std::vector<double>& rates = zeroCurve.zeroRates();
+    double value = 0;
+    for (std::size_t j = bonds.offsets[bond]; j < bonds.offsets[bond + 1]; j++)
+    {
+        double rate = leftWeight[j] * rates[left[j]] + (1 - leftWeight[j]) * rates[right[j]];
+        value += bonds.amounts[j] * exp(-rate * bonds.times[j]);
+    }
+    return value;
+}
+
+void YieldCurveBootstrapper::buildNodes() {
+    std::size_t n = bonds.size();
+
+    std::vector<double> maturities(n);
+    for (std::size_t i = 0; i < n; i++)
+        maturities[i] = bonds.times[bonds.offsets[i + 1] - 1];
+
+    std::vector<double> times(maturities);
+    std::sort(times.begin(), times.end());
+    times.erase(std::unique(times.begin(), times.end()), times.end());
+
+    //keep the rates of nodes that already existed as the starting point
+    std::vector<double> rates(times.size(), 0.02);
+    for (std::size_t k = 0; k < times.size() && zeroCurve.size() > 0; k++)
+        rates[k] = zeroCurve.zeroRate(times[k]);
+
+    zeroCurve = YieldCurve(times, rates);
+
+    bondNode.resize(n);
+    nodeBonds.assign(times.size(), std::vector<std::size_t>());
+    for (std::size_t i = 0; i < n; i++)
+    {
+        bondNode[i] = std::size_t(std::lower_bound(times.begin(), times.end(), maturities[i]) - times.begin());
+        nodeBonds[bondNode[i]].push_back(i);
+    }
+
+    left.resize(bonds.times.size());
+    right.resize(bonds.times.size());
+    leftWeight.resize(bonds.times.size());
+    for (std::size_t j = 0; j < bonds.times.size(); j++)
+        zeroCurve.interpolation(bonds.times[j], left[j], right[j], leftWeight[j]);
+
+    structureChanged = false;
+    firstDirtyNode = 0;
+}
+
+const YieldCurve& YieldCurveBootstrapper::bootstrap() {
+    if (structureChanged)
+        buildNodes();
+
+    solvedNodes = 0;
+    for (std::size_t k = firstDirtyNode; k < zeroCurve.size(); k++)
+    {
+        solveNode(k);
+        solvedNodes++;
+    }
+
+    firstDirtyNode = zeroCurve.size();
+    return zeroCurve;
+}
+
+void YieldCurveBootstrapper::solveNode(std::size_t node) {
+    const std::vector<double>& rates = zeroCurve.zeroRates();
+    const std::vector<std::size_t>& nodeBond = nodeBonds[node];
+
+    //split every bond at this node into the value of the cashflows fixed by earlier nodes and the ones that move with this node
+    std::vector<double> fixedValue(nodeBond.size(), 0.0);
+    std::vector<std::size_t> moving;
+    std::vector<std::size_t> movingOwner;
+    for (std::size_t b = 0; b < nodeBond.size(); b++)
+    {
+        std::size_t i = nodeBond[b];
+        for (std::size_t j = bonds.offsets[i]; j < bonds.offsets[i + 1]; j++)
+        {
+            if (left[j] == node || right[j] == node)
+            {
+                moving.push_back(j);
+                movingOwner.push_back(b);
+            }
+            else
+            {
+                double rate = leftWeight[j] * rates[left[j]] + (1 - leftWeight[j]) * rates[right[j]];
+                fixedValue[b] += bonds.amounts[j] * exp(-rate * bonds.times[j]);
+            }
+        }
+    }
+
+    //warm start from the current rate, a fresh node starts from its neighbour
+    double z = rates[node];
+    std::vector<double> value(nodeBond.size()), slope(nodeBond.size());
+
+    for (int iteration = 0; iteration < maxIterations; iteration++)
+    {
+        value = fixedValue;
+        std::fill(slope.begin(), slope.end(), 0.0);
+
+        for (std::size_t m = 0; m < moving.size(); m++)
+        {
+            std::size_t j = moving[m];
+            double leftRate = left[j] == node ? z : rates[left[j]];
+            double rightRate = right[j] == node ? z : rates[right[j]];
+            double weight = (left[j] == node ? leftWeight[j] : 0.0) + (right[j] == node ? 1 - leftWeight[j] : 0.0);
+            double rate = leftWeight[j] * leftRate + (1 - leftWeight[j]) * rightRate;
+            double discounted = bonds.amounts[j] * exp(-rate * bonds.times[j]);
+
+            value[movingOwner[m]] += discounted;
+            slope[movingOwner[m]] -= weight * bonds.times[j] * discounted;
+        }
+
+        //Gauss-Newton on the sum of squared pricing errors, plain Newton when one bond matures here
+        double gradient = 0, curvature = 0;
+        for (std::size_t b = 0; b < nodeBond.size(); b++)
+        {
+            double residual = value[b] - bonds.prices[nodeBond[b]];
+            gradient += residual * slope[b];
+            curvature += slope[b] * slope[b];
+        }
+
+        double step = gradient / curvature;
+        z -= step;
+        zeroCurve.setZeroRate(node, z);
+
+        if (!(std::abs(step) > tolerance))
+            break;
+    }
+}
+
+const YieldCurve& YieldCurveBootstrapper::fitLeastSquares() {
+    //the sequential curve is the starting point, and is already close after a price update
+    bootstrap();
+
+    std::size_t n = zeroCurve.size();
+    std::size_t m = bonds.size();
+    std::vector<double> rates = zeroCurve.zeroRates();
+    std::vector<double> residual(m), jacobian(m * n);
+
+    //residuals and jacobian d(value_i)/d(rate_k) for the given rates, returns the sum of squared residuals
+    auto evaluate = [&](const std::vector<double>& z) {
+        double cost = 0;
+        std::fill(jacobian.begin(), jacobian.end(), 0.0);
+        for (std::size_t i = 0; i < m; i++)
+        {
+            double value = 0;
+            for (std::size_t j = bonds.offsets[i]; j < bonds.offsets[i + 1]; j++)
+            {
+                double rate = leftWeight[j] * z[left[j]] + (1 - leftWeight[j]) * z[right[j]];
+                double discounted = bonds.amounts[j] * exp(-rate * bonds.times[j]);
+                value += discounted;
+                jacobian[i * n + left[j]] -= leftWeight[j] * bonds.times[j] * discounted;
+                jacobian[i * n + right[j]] -= (1 - leftWeight[j]) * bonds.times[j] * discounted;
+            }
+            residual[i] = value - bonds.prices[i];
+            cost += residual[i] * residual[i];
+        }
+        return cost;
+    };
+
+    double lambda = 1e-3;
+    double cost = evaluate(rates);
+
+    for (int iteration = 0; iteration < maxIterations; iteration++)
+    {
+        //normal equations (J'J + lambda*diag(J'J)) step = -J'r
+        std::vector<double> a(n * n, 0.0), g(n, 0.0);
+        for (std::size_t i = 0; i < m; i++)
+        {
+            for (std::size_t k = 0; k < n; k++)
+            {
+                double jik = jacobian[i * n + k];
+                if (jik == 0)
+                    continue;
+                g[k] -= jik * residual[i];
+                for (std::size_t l = 0; l < n; l++)
+                    a[k * n + l] += jik * jacobian[i * n + l];
+            }
+        }
+        for (std::size_t k = 0; k < n; k++)
+            a[k * n + k] *= 1 + lambda;
+
+        //Gaussian elimination with partial pivoting
+        std::vector<double> step(g);
+        for (std::size_t c = 0; c < n; c++)
+        {
+            std::size_t pivot = c;
+            for (std::size_t r = c + 1; r < n; r++)
+                if (std::abs(a[r * n + c]) > std::abs(a[pivot * n + c]))
+                    pivot = r;
+            if (pivot != c)
+            {
+                for (std::size_t l = 0; l < n; l++)
+                    std::swap(a[c * n + l], a[pivot * n + l]);
+                std::swap(step[c], step[pivot]);
+            }
+            for (std::size_t r = c + 1; r < n; r++)
+            {
+                double factor = a[r * n + c] / a[c * n + c];
+                for (std::size_t l = c; l < n; l++)
+                    a[r * n + l] -= factor * a[c * n + l];
+                step[r] -= factor * step[c];
+            }
+        }
+        for (std::size_t c = n; c-- > 0;)
+        {
+            for (std::size_t l = c + 1; l < n; l++)
+                step[c] -= a[c * n + l] * step[l];
+            step[c] /= a[c * n + c];
+        }
+
+        std::vector<double> trial(rates);
+        double largestStep = 0;
+        for (std::size_t k = 0; k < n; k++)
+        {
+            trial[k] += step[k];
+            largestStep = std::max(largestStep, std::abs(step[k]));
+        }
+
+        std::vector<double> savedResidual(residual), savedJacobian(jacobian);
+        double trialCost = evaluate(trial);
+        if (trialCost <= cost)
+        {
+            rates = trial;
+            cost = trialCost;
+            lambda = std::max(lambda / 10, 1e-12);
+        }
+        else
+        {
+            residual = savedResidual;
+            jacobian = savedJacobian;
+            lambda *= 10;
+        }
+
+        if (largestStep <= tolerance)
+            break;
+    }
+
+    for (std::size_t k = 0; k < n; k++)
+        zeroCurve.setZeroRate(k, rates[k]);
+
+    return zeroCurve;
+}
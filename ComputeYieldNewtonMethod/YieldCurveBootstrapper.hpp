@@ -0,0 +1,61 @@
+#ifndef YIELD_CURVE_BOOTSTRAPPER_HPP
+#define YIELD_CURVE_BOOTSTRAPPER_HPP
+
+#include <cstddef>
+#include <vector>
+#include "BatchYieldSolver.hpp"
+#include "YieldCurve.hpp"
+
+class ComputeYieldNewtonMethod;
+
+//Builds a zero curve from bond prices, one curve node per distinct bond maturity
+//
+//bootstrap() solves the nodes one at a time in maturity order: a node only moves the bonds maturing there once
+//every earlier node is known, so the discount factors of all cashflows before the previous node are summed once and reused.
+//After setPrice() only the nodes from the earliest changed maturity onwards are re-solved, warm started from the last curve.
+//fitLeastSquares() instead fits all nodes at once (Levenberg-Marquardt), which also handles several bonds per maturity.
+class YieldCurveBootstrapper {
+
+public:
+    YieldCurveBootstrapper(double tolerance = 1e-12, int maxIterations = 50);
+
+    //returns the index used to refer to the bond in setPrice/bondValue
+    std::size_t addBond(const ComputeYieldNewtonMethod& bond);
+    void setPrice(std::size_t bond, double price);
+
+    const YieldCurve& bootstrap();
+    const YieldCurve& fitLeastSquares();
+
+    const YieldCurve& curve() const;
+    //value of a bond on the current curve
+    double bondValue(std::size_t bond) const;
+    //number of nodes re-solved by the last bootstrap()
+    std::size_t lastSolvedNodes() const;
+
+private:
+    //node times, the bonds of each node and the interpolation of every cashflow, redone whenever bonds are added
+    void buildNodes();
+
+    //1-D Gauss-Newton on the zero rate of one node, the earlier nodes stay fixed
+    void solveNode(std::size_t node);
+
+private:
+    BondUniverse bonds;
+    std::vector<std::size_t> bondNode;
+    std::vector<std::vector<std::size_t> > nodeBonds;
+
+    //per cashflow: rate(t) = leftWeight * rate[left] + (1 - leftWeight) * rate[right]
+    std::vector<std::size_t> left;
+    std::vector<std::size_t> right;
+    std::vector<double> leftWeight;
+
+    YieldCurve zeroCurve;
+    bool structureChanged;
+    std::size_t firstDirtyNode;     //equal to the number of nodes when the curve is up to date
+    std::size_t solvedNodes;
+
+    double tolerance;
+    int maxIterations;
+};
+
+#endif
@@ -1,6 +1,9 @@
 #include <iostream>
 #include <iomanip>
 #include "ComputeYieldNewtonMethod.hpp"
+#include "BatchYieldSolver.hpp"
+#include "YieldCurveBootstrapper.hpp"
+#include "KeyRateRiskEngine.hpp"
 
 int main() {
 
@@ -27,4 +30,56 @@ int main() {
     std::cout << "Yield (tuple) = " << std::get<0>(result) << std::endl;
     std::cout << "Duration (tuple) = " << std::get<1>(result) << std::endl;
     std::cout << "Convexity (tuple) = " << std::get<2>(result) << std::endl;
+
+    // the same bond solved in a batch next to a 10 year semiannual and a 30 year annual bond
+    BondUniverse bonds;
+    bonds.add(yieldComputer);
+    bonds.add(ComputeYieldNewtonMethod(120, 6, 0.03, 100, 97));
+    bonds.add(ComputeYieldNewtonMethod(360, 12, 0.045, 100, 110));
+
+    double yields[3], durations[3], convexities[3];
+    BatchYieldSolver batchSolver;
+    batchSolver.solve(bonds, startingValue, yields, durations, convexities);
+
+    for (int i = 0; i < 3; i++) {
+        std::cout << "Bond " << i << " Yield = " << yields[i] << " Duration = " << durations[i] << " Convexity = " << convexities[i] << std::endl;
+    }
+
+    // streaming price ticks, each re-solve starts from the previous yield
+    double ticks[] = { 104.0, 104.05, 103.98, 103.9, 60.0 };
+    for (int i = 0; i < 5; i++) {
+        double tickYield = yieldComputer.updatePrice(ticks[i]);
+        std::cout << "Price = " << ticks[i] << " Yield = " << tickYield << " (" << yieldComputer.getLastIterations() << " iterations)" << std::endl;
+    }
+
+    // zero curve bootstrapped from three par-ish bonds, then rebuilt after the 10 year price moves
+    YieldCurveBootstrapper bootstrapper;
+    bootstrapper.addBond(ComputeYieldNewtonMethod(12, 12, 0.02, 100, 100.1));
+    bootstrapper.addBond(ComputeYieldNewtonMethod(60, 12, 0.025, 100, 100.4));
+    std::size_t tenYear = bootstrapper.addBond(ComputeYieldNewtonMethod(120, 6, 0.03, 100, 99.5));
+
+    const YieldCurve& curve = bootstrapper.bootstrap();
+    for (std::size_t k = 0; k < curve.size(); k++) {
+        std::cout << "T = " << curve.nodeTimes()[k] << " Zero Rate = " << curve.zeroRates()[k] << std::endl;
+    }
+
+    bootstrapper.setPrice(tenYear, 99.0);
+    bootstrapper.bootstrap();
+    std::cout << "Re-solved " << bootstrapper.lastSolvedNodes() << " node(s), 10 year Zero Rate = " << curve.zeroRates()[2] << std::endl;
+
+    // key-rate risk of the batch bonds on the bootstrapped curve, 10 of each held
+    std::vector<double> keyTenors = { 1, 5, 10, 30 };
+    KeyRateRiskEngine riskEngine(bonds, std::vector<double>(bonds.size(), 10.0), curve, keyTenors);
+
+    double portfolioValue;
+    std::vector<double> keyRateDurations, keyRateConvexities;
+    riskEngine.portfolioRisk(portfolioValue, keyRateDurations, keyRateConvexities);
+    std::cout << "Portfolio Value = " << portfolioValue << std::endl;
+    for (std::size_t k = 0; k < keyTenors.size(); k++) {
+        std::cout << "Key Rate " << keyTenors[k] << "y Duration = " << keyRateDurations[k] << " Convexity = " << keyRateConvexities[k] << std::endl;
+    }
+
+    std::vector<CurveScenario> scenarios = { CurveScenario::parallel(keyTenors, 0.01), CurveScenario::twist(keyTenors, -0.005, 0.005) };
+    std::vector<double> scenarioValues = riskEngine.scenarioValues(scenarios);
+    std::cout << "+100bp Parallel Value = " << scenarioValues[0] << " Steepener Value = " << scenarioValues[1] << std::endl;
 }
\ No newline at end of file
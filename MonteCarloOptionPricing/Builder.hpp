@@ -22,6 +22,7 @@
 #include"SDE.hpp"
 #include"FDM.hpp"
 #include"RNG.hpp"
+#include"Sobol.hpp"
 #include<memory>
 #include<iostream>
 
@@ -126,7 +127,7 @@ private:
 		std::cout << "----------Choosing the FDM----------\n";
 		int c;
 
-		std::cout << "Enter 1 = Euler, 2 = Milstein, 3 = ModifiedPredictorCorrector : ";
+		std::cout << "Enter 1 = Euler, 2 = Milstein, 3 = ModifiedPredictorCorrector, 4 = ExactGBM : ";
 		std::cin >> c;
 
 		int NT;
@@ -144,6 +145,11 @@ private:
 			std::cout << "Enter a of the Modified Predictor Corrector : "; std::cin >> a;
 			std::cout << "Enter b of the Modified Predictor Corrector : "; std::cin >> b;
 			return std::make_shared<ModifiedPredictorCorrectorFDM>(sde, NT, a, b);
+		case 4://ExactGBM, only for the GBM model
+			if (auto gbm = std::dynamic_pointer_cast<GBM>(sde))
+				return std::make_shared<ExactGBMFDM>(gbm, NT);
+			std::cout << "ExactGBM needs the GBM model, using Euler\n";
+			return std::make_shared<EulerFDM>(sde, NT);
 		default://for all other input including wrong input, we return Euler as default
 			return std::make_shared<EulerFDM>(sde, NT);
 		}
@@ -155,7 +161,7 @@ private:
 		std::cout << "----------Choosing the RNG----------\n";
 		int c;
 
-		std::cout << "Enter 1 = Mersenne Twister Normal Distribution, 2 = BoxMuller, 3 = PolarMarsaglia : ";
+		std::cout << "Enter 1 = Mersenne Twister Normal Distribution, 2 = BoxMuller, 3 = PolarMarsaglia, 4 = Philox, 5 = Ziggurat, 6 = Sobol(QMC) : ";
 		std::cin >> c;
 
 		switch (c)
@@ -166,6 +172,17 @@ private:
 			return  std::make_shared<BoxMullerRNG>();
 		case 3://Polar Marsaglia
 			return std::make_shared<PolarMarsagliaRNG>();
+		case 4://Philox, seed and stream are required in runtime
+			unsigned long seed, stream;
+			std::cout << "Enter seed of the Philox generator : "; std::cin >> seed;
+			std::cout << "Enter stream of the Philox generator : "; std::cin >> stream;
+			return std::make_shared<PhiloxRNG>(seed, stream);
+		case 5://Ziggurat, seed is required in runtime
+			std::cout << "Enter seed of the Ziggurat generator : "; std::cin >> seed;
+			return std::make_shared<ZigguratRNG>(seed);
+		case 6://Sobol with Brownian bridge, digital shift from the seed
+			std::cout << "Enter seed of the Sobol scrambling : "; std::cin >> seed;
+			return std::make_shared<SobolRNG>(true, seed);
 		default://for all other input including wrong input, we return MTNormal as default
 			return std::make_shared<MTNormalRNG>(0, 1);
 		}
@@ -0,0 +1,62 @@
+//
+// ControlVariate.hpp
+//
+// Closed form control variates for the pricers, evaluated on the exact GBM shadow path that the mediator builds from
+// the same normals as the simulated path (MCMediator::EnableControlVariate)
+//
+// EuropeanControl : the vanilla payoff of the shadow path's end point, its mean is the Black Scholes price
+// GeometricAsianControl : the geometric average payoff of the shadow path (all NT+1 points, like the averages in main),
+//		its mean is the closed form of the discretely monitored geometric Asian option
+//
+// Both means are undiscounted, like the payoffs the pricers accumulate
+//
+//
+
+#ifndef CONTROL_VARIATE_HPP
+#define CONTROL_VARIATE_HPP
+
+#include"Pricer.hpp"
+#include"../BlackScholesOptionPricer/BlackScholesOptionPricer.hpp"
+#include<cmath>
+#include<algorithm>
+
+//Control variate for European options: payoff of the exact GBM end point, mean = Black Scholes price * exp(rT)
+inline ControlVariate EuropeanControl(bool isCall, double strike, double S0, double rate, double vol, double div, double T)
+{
+	BlackScholesOptionPricer bs(S0, strike, rate, div, vol, T);
+
+	ControlVariate control;
+	control.mean = (isCall ? bs.callPrice() : bs.putPrice()) * std::exp(rate * T);
+	control.terminalOnly = true;
+	control.value = [isCall, strike](const PathState& shadow)
+	{
+		return isCall ? std::max(0.0, shadow.last - strike) : std::max(0.0, strike - shadow.last);
+	};
+	return control;
+}
+
+//Control variate for Asian options: geometric average of the NT+1 exact GBM points
+//log G is normal with mean ln S0 + (r - q - vol^2/2) T/2 and variance vol^2 dt NT(2NT+1)/(6(NT+1))
+inline ControlVariate GeometricAsianControl(bool isCall, double strike, double S0, double rate, double vol, double div, double T, int NT)
+{
+	double dt = T / NT;
+	double mu = std::log(S0) + (rate - div - 0.5 * vol * vol) * T / 2.0;
+	double sigma = std::sqrt(vol * vol * dt * NT * (2.0 * NT + 1.0) / (6.0 * (NT + 1.0)));
+
+	double d1 = (mu - std::log(strike) + sigma * sigma) / sigma;
+	double d2 = d1 - sigma;
+	double forward = std::exp(mu + 0.5 * sigma * sigma);		//E[G]
+
+	ControlVariate control;
+	control.mean = isCall ? forward * BlackScholesOptionPricer::N(d1) - strike * BlackScholesOptionPricer::N(d2)
+		: strike * BlackScholesOptionPricer::N(-d2) - forward * BlackScholesOptionPricer::N(-d1);
+	control.value = [isCall, strike](const PathState& shadow)
+	{
+		double G = std::exp(shadow.LogSum() / shadow.points);
+		return isCall ? std::max(0.0, G - strike) : std::max(0.0, strike - G);
+	};
+	return control;
+}
+
+#endif
+
@@ -0,0 +1,253 @@
+//
+// Engine.hpp
+//
+// Compile time path kernels for the mediator
+//
+// The IFDM path makes a virtual advance call per time step, which calls the virtual Drift and Diffusion of the SDE
+// through a shared pointer. MCEngine<SDE, Scheme, RNG> is instantiated for a concrete SDE (GBM or CEV, both final),
+// a scheme policy and a concrete generator, so the whole time step inlines and only one virtual call per path remains
+//
+// Four Scheme policies : EulerScheme, MilsteinScheme, PredictorCorrectorScheme and ExactGBMScheme (same formulas as
+//		the FDM classes)
+// One Interface : IPathEngine, what the mediator calls, one path at a time (Simulate) or a block of paths in lockstep
+//		(SimulateBlock, vectorized across the paths since the steps of one path depend on each other)
+// With ContinuousMonitoring(true) a path also draws four normals per step after its NT increments, for the exponential
+//		draws of the Brownian bridge max and min of the step (PathState::AddBridged)
+// MakeEngine(parts) : dispatches the builder's runtime choices to the matching instantiation, nullptr if there is none
+//		(the mediator then keeps using the IFDM classes, which remain the flexible fallback)
+//
+//
+//
+
+#ifndef ENGINE_HPP
+#define ENGINE_HPP
+
+#include"SDE.hpp"
+#include"FDM.hpp"
+#include"RNG.hpp"
+#include"Sobol.hpp"
+#include"Pricer.hpp"
+#include"PathBlock.hpp"
+#include"Builder.hpp"
+#include<vector>
+#include<memory>
+#include<cmath>
+
+//Euler Scheme policy: X(n+1) = X(n) + mu*dt + sig*dW
+struct EulerScheme
+{
+	template<class SDE>
+	double advance(SDE& sde, double xn, double dt, double sqrtDt, double normalVar) const
+	{
+		return xn + sde.Drift(xn) * dt + sde.Diffusion(xn) * sqrtDt * normalVar;
+	}
+};
+
+//Milstein Scheme policy
+struct MilsteinScheme
+{
+	template<class SDE>
+	double advance(SDE& sde, double xn, double dt, double sqrtDt, double normalVar) const
+	{
+		return xn + sde.Drift(xn) * dt + sde.Diffusion(xn) * sqrtDt * normalVar
+			+ 0.5 * dt * sde.Diffusion(xn) * sde.DiffusionDerivative(xn) * (normalVar * normalVar - 1.0);
+	}
+};
+
+//Modified Predictor Corrector Scheme policy, a and b as in ModifiedPredictorCorrectorFDM
+struct PredictorCorrectorScheme
+{
+	double m_A;
+	double m_B;
+
+	PredictorCorrectorScheme(double a, double b) : m_A(a), m_B(b) {}
+
+	template<class SDE>
+	double advance(SDE& sde, double xn, double dt, double sqrtDt, double normalVar) const
+	{
+		//Euler for predictor
+		double VMid = xn + sde.Drift(xn) * dt + sde.Diffusion(xn) * sqrtDt * normalVar;
+
+		// Modified Trapezoidal rule, using adjusted drift
+		double driftTerm = (m_A * sde.DriftCorrected(VMid, m_B) + ((1.0 - m_A) * sde.DriftCorrected(xn, m_B))) * dt;
+		double diffusionTerm = (m_B * sde.Diffusion(VMid) + ((1.0 - m_B) * sde.Diffusion(xn))) * sqrtDt * normalVar;
+
+		return xn + driftTerm + diffusionTerm;
+	}
+};
+
+
+//Exact GBM Scheme policy, the coefficients of one mesh step as precomputed by ExactGBMFDM
+struct ExactGBMScheme
+{
+	double m_driftStep;
+	double m_diffusionStep;
+
+	ExactGBMScheme(double driftStep, double diffusionStep) : m_driftStep(driftStep), m_diffusionStep(diffusionStep) {}
+
+	template<class SDE>
+	double advance(SDE& sde, double xn, double dt, double sqrtDt, double normalVar) const
+	{
+		return xn * std::exp(m_driftStep + m_diffusionStep * normalVar);
+	}
+};
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+//Abstract Base(Interface) path kernel, called once per path by the mediator
+class IPathEngine
+{
+public:
+	virtual ~IPathEngine() {}
+
+	//draw the normals of a path, rng must be the generator type the engine was made for (or one of its streams)
+	virtual void Normals(IRNG& rng, std::vector<double>& normals) = 0;
+
+	//take the Brownian bridge extremes of every step into the max and min, the paths then need 5 NT normals (NT increments, then four per step)
+	virtual void ContinuousMonitoring(bool on) = 0;
+
+	//generate one path from the given normals into its running state
+	virtual void Simulate(const std::vector<double>& normals, PathState& path) = 0;
+
+	//generate size paths in lockstep, normals are time major: normals[n * size + p] is the n-th normal of path p
+	virtual void SimulateBlock(const double* normals, int size, PathBlock& block) = 0;
+};
+
+
+//Concrete path kernel for one SDE, Scheme and RNG combination
+template<class SDE, class Scheme, class RNG>
+class MCEngine final : public IPathEngine
+{
+private:
+	SDE m_sde;			//copied, the final SDE class lets every Drift/Diffusion call inline
+	Scheme m_scheme;
+	int m_NT;			//Number of time intervals
+	double m_dt;		//Mesh size
+	double m_sqrtDt;	//computed once instead of every step
+	bool m_continuous;	//Brownian bridge extremes
+public:
+	//Constructor
+	MCEngine(const SDE& sde, const Scheme& scheme, int NT, double dt)
+		: m_sde(sde), m_scheme(scheme), m_NT(NT), m_dt(dt), m_sqrtDt(std::sqrt(dt)), m_continuous(false) {}
+
+	virtual void ContinuousMonitoring(bool on) override
+	{
+		m_continuous = on;
+	}
+
+	virtual void Normals(IRNG& rng, std::vector<double>& normals) override
+	{
+		static_cast<RNG&>(rng).Fill(normals.data(), normals.size());	//RNG is final, a direct call
+	}
+
+	virtual void Simulate(const std::vector<double>& normals, PathState& path) override
+	{
+		SDE sde = m_sde;		//local copy, the engine is shared by the parallel workers
+		PathState state;		//local so it stays in registers, path could alias the normals
+		double x = sde.InitialCondition();
+		state.Start(x);
+
+		if (m_continuous)
+		{
+			//the log variance of the step from the local volatility at its start
+			for (int n = 0; n < m_NT; n++)
+			{
+				double s = sde.Diffusion(x) / x;
+				x = m_scheme.advance(sde, x, m_dt, m_sqrtDt, normals[n]);
+				const double* e = &normals[m_NT + 4 * n];
+				state.AddBridged(x, s * s * m_dt, PathState::Exponential(e[0], e[1]), PathState::Exponential(e[2], e[3]));
+			}
+			path = state;
+			return;
+		}
+
+		for (int n = 0; n < m_NT; n++)
+		{
+			x = m_scheme.advance(sde, x, m_dt, m_sqrtDt, normals[n]);
+			state.Add(x);
+		}
+		path = state;
+	}
+
+	virtual void SimulateBlock(const double* normals, int size, PathBlock& block) override
+	{
+		SDE sde = m_sde;
+		Scheme scheme = m_scheme;
+		double dt = m_dt, sqrtDt = m_sqrtDt;
+		block.Start(sde.InitialCondition(), size);
+
+		for (int n = 0; n < m_NT; n++)
+		{
+			const double* z = normals + std::size_t(n) * size;
+			auto step = [&](int p, double x) { return scheme.advance(sde, x, dt, sqrtDt, z[p]); };
+			if (m_continuous)
+			{
+				const double* e = normals + std::size_t(m_NT + 4 * n) * size;
+				block.AdvanceBridged(size, step, [&](int p, double x) { double s = sde.Diffusion(x) / x; return s * s * dt; }, e);
+			}
+			else
+			{
+				block.Advance(size, step);
+			}
+		}
+	}
+};
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+//Runtime dispatch, one level per template parameter
+
+//RNG level
+template<class SDE, class Scheme>
+std::shared_ptr<IPathEngine> MakeEngine(const SDE& sde, const Scheme& scheme, const IFDM& fdm, const RNGPointer& rng)
+{
+	if (std::dynamic_pointer_cast<MTNormalRNG>(rng))
+		return std::make_shared<MCEngine<SDE, Scheme, MTNormalRNG>>(sde, scheme, fdm.m_NT, fdm.m_k);
+	if (std::dynamic_pointer_cast<BoxMullerRNG>(rng))
+		return std::make_shared<MCEngine<SDE, Scheme, BoxMullerRNG>>(sde, scheme, fdm.m_NT, fdm.m_k);
+	if (std::dynamic_pointer_cast<PolarMarsagliaRNG>(rng))
+		return std::make_shared<MCEngine<SDE, Scheme, PolarMarsagliaRNG>>(sde, scheme, fdm.m_NT, fdm.m_k);
+	if (std::dynamic_pointer_cast<PhiloxRNG>(rng))
+		return std::make_shared<MCEngine<SDE, Scheme, PhiloxRNG>>(sde, scheme, fdm.m_NT, fdm.m_k);
+	if (std::dynamic_pointer_cast<ZigguratRNG>(rng))
+		return std::make_shared<MCEngine<SDE, Scheme, ZigguratRNG>>(sde, scheme, fdm.m_NT, fdm.m_k);
+	if (std::dynamic_pointer_cast<SobolRNG>(rng))
+		return std::make_shared<MCEngine<SDE, Scheme, SobolRNG>>(sde, scheme, fdm.m_NT, fdm.m_k);
+	return nullptr;
+}
+
+//Scheme level
+template<class SDE>
+std::shared_ptr<IPathEngine> MakeEngine(const SDE& sde, const FDMPointer& fdm, const RNGPointer& rng)
+{
+	if (std::dynamic_pointer_cast<EulerFDM>(fdm))
+		return MakeEngine(sde, EulerScheme(), *fdm, rng);
+	if (std::dynamic_pointer_cast<MilsteinFDM>(fdm))
+		return MakeEngine(sde, MilsteinScheme(), *fdm, rng);
+	if (auto pc = std::dynamic_pointer_cast<ModifiedPredictorCorrectorFDM>(fdm))
+		return MakeEngine(sde, PredictorCorrectorScheme(pc->A(), pc->B()), *fdm, rng);
+	if (auto exact = std::dynamic_pointer_cast<ExactGBMFDM>(fdm))
+		return MakeEngine(sde, ExactGBMScheme(exact->DriftStep(), exact->DiffusionStep()), *fdm, rng);
+	return nullptr;
+}
+
+//SDE level, the SDE is the one the FDM steps
+inline std::shared_ptr<IPathEngine> MakeEngine(const BuilderTuple& parts)
+{
+	FDMPointer fdm = std::get<1>(parts);
+	RNGPointer rng = std::get<2>(parts);
+
+	if (auto gbm = std::dynamic_pointer_cast<GBM>(fdm->StochasticEquation()))
+		return MakeEngine(*gbm, fdm, rng);
+	if (auto cev = std::dynamic_pointer_cast<CEV>(fdm->StochasticEquation()))
+		return MakeEngine(*cev, fdm, rng);
+	return nullptr;
+}
+
+#endif
@@ -4,7 +4,12 @@
 // Finite Difference Methods for the SDE classes
 //
 // One Base class : IFDM
-// Three selected FDM Models as the Derived classes : Euler, Milstein, and ModifiedPredictorCorrector
+// Four selected FDM Models as the Derived classes : Euler, Milstein, ModifiedPredictorCorrector and ExactGBM
+// ExactGBM steps the log of a GBM exactly, so it has no discretization bias whatever NT
+//
+// derivatives() differentiates one step for the Monte Carlo Greeks: the pathwise tangents are carried through the
+// steps with it, and StepDerivatives::Score turns it into the likelihood ratio weight of the step. Euler, Milstein and
+// ExactGBM implement it, the other schemes return false and their Greeks are bumped instead
 //
 //
 //
@@ -19,6 +24,25 @@
 //For readability
 using SDEPointer = std::shared_ptr<ISDE>;
 
+//Partial derivatives of one step X(n+1) = advance(X(n), z), z the normal variate
+struct StepDerivatives
+{
+	double dx;		//d X(n+1) / d X(n)
+	double dvol;	//d X(n+1) / d vol
+	double dz;		//d X(n+1) / dz
+	double dzz;		//d2 X(n+1) / dz2
+	double dzx;		//d2 X(n+1) / dz d X(n)
+	double dzvol;	//d2 X(n+1) / dz d vol
+
+	//d log p / d theta of the density p of X(n+1) given X(n), from dX(n+1)/dtheta and d2X(n+1)/dz dtheta
+	//the step is increasing in z, so p(X(n+1)) = phi(z) / (dX(n+1)/dz) with z moving as theta moves and X(n+1) is fixed
+	double Score(double dtheta, double dztheta, double normalVar) const
+	{
+		double zTheta = -dtheta / dz;		//dz / d theta, X(n+1) fixed
+		return -normalVar * zTheta - (dztheta + dzz * zTheta) / dz;
+	}
+};
+
 //Abstract Base(Interface) FDM class : contains the mandatory elements and functions of DFM
 //For one-factor FDM in particular
 class IFDM
@@ -67,6 +91,12 @@ public:
 
 	//Pure virtual functions
 	virtual double advance(double  xn, double  tn, double  dt, double  normalVar) = 0;
+
+	//Derivatives of the advance step for the Greeks, false if the scheme does not provide them
+	virtual bool derivatives(double  xn, double  tn, double  dt, double  normalVar, StepDerivatives& d)
+	{
+		return false;
+	}
 };
 
 
@@ -87,6 +117,20 @@ public:
 	{//Compute the value at tn+dt using Euler's Method
 		return xn + m_sde->Drift(xn) * dt + m_sde->Diffusion(xn) *  std::sqrt(dt) * normalVar;
 	}
+
+	//Derived Derivatives Function
+	virtual bool derivatives(double  xn, double  tn, double  dt, double  normalVar, StepDerivatives& d) override
+	{
+		double sqrtDt = std::sqrt(dt);
+		double b = m_sde->Diffusion(xn), vol = m_sde->Volatility();
+		d.dx = 1.0 + m_sde->DriftDerivative(xn) * dt + m_sde->DiffusionDerivative(xn) * sqrtDt * normalVar;
+		d.dvol = b / vol * sqrtDt * normalVar;
+		d.dz = b * sqrtDt;
+		d.dzz = 0.0;
+		d.dzx = m_sde->DiffusionDerivative(xn) * sqrtDt;
+		d.dzvol = b / vol * sqrtDt;
+		return true;
+	}
 };
 
 
@@ -107,6 +151,23 @@ public:
 		return xn + m_sde->Drift(xn) * dt + m_sde->Diffusion(xn) * std::sqrt(dt) * normalVar
 			+ 0.5 * dt * m_sde->Diffusion(xn) * m_sde->DiffusionDerivative(xn) * (normalVar * normalVar - 1.0);
 	}
+
+	//Derived Derivatives Function
+	virtual bool derivatives(double  xn, double  tn, double  dt, double  normalVar, StepDerivatives& d) override
+	{
+		double sqrtDt = std::sqrt(dt);
+		double b = m_sde->Diffusion(xn), bx = m_sde->DiffusionDerivative(xn), vol = m_sde->Volatility();
+		double g = b * bx;													//b b', proportional to vol^2
+		double gx = bx * bx + b * m_sde->DiffusionSecondDerivative(xn);	//(b b')'
+		double z2 = normalVar * normalVar - 1.0;
+		d.dx = 1.0 + m_sde->DriftDerivative(xn) * dt + bx * sqrtDt * normalVar + 0.5 * dt * gx * z2;
+		d.dvol = (b * sqrtDt * normalVar + dt * g * z2) / vol;
+		d.dz = b * sqrtDt + dt * g * normalVar;
+		d.dzz = dt * g;
+		d.dzx = bx * sqrtDt + dt * gx * normalVar;
+		d.dzvol = (b * sqrtDt + 2.0 * dt * g * normalVar) / vol;
+		return true;
+	}
 };
 
 
@@ -121,26 +182,93 @@ private:
 	//Some factors
 	double m_A;
 	double m_B;
-	double m_VMid;
 public:
 	//Constructors
 	ModifiedPredictorCorrectorFDM(SDEPointer stochasticEquation, int numSubdivisions, double  a, double  b)
-		: IFDM(stochasticEquation, numSubdivisions), m_A(a), m_B(b), m_VMid(0) {}
+		: IFDM(stochasticEquation, numSubdivisions), m_A(a), m_B(b) {}
+
+	//Getters of the factors
+	virtual double A() const final
+	{
+		return m_A;
+	}
+	virtual double B() const final
+	{
+		return m_B;
+	}
 
 	//Derived Advance Function
 	virtual double  advance(double  xn, double  tn, double  dt, double  normalVar) override
 	{//Compute the value at tn+dt using Modified Predictor Corrector
 
-	 //Euler for predictor
-		m_VMid = xn + m_sde->Drift(xn) * dt + m_sde->Diffusion(xn) * std::sqrt(dt) * normalVar;
+	 //Euler for predictor, kept local so parallel workers can share the scheme
+		double VMid = xn + m_sde->Drift(xn) * dt + m_sde->Diffusion(xn) * std::sqrt(dt) * normalVar;
 
 		// Modified Trapezoidal rule, using adjusted drift
-		double  driftTerm = (m_A * m_sde->DriftCorrected(m_VMid, m_B) + ((1.0 - m_A) * m_sde->DriftCorrected(xn, m_B))) * dt;
-		double  diffusionTerm = (m_B * m_sde->Diffusion(m_VMid) + ((1.0 - m_B) * m_sde->Diffusion(xn))) * std::sqrt(dt) * normalVar;
+		double  driftTerm = (m_A * m_sde->DriftCorrected(VMid, m_B) + ((1.0 - m_A) * m_sde->DriftCorrected(xn, m_B))) * dt;
+		double  diffusionTerm = (m_B * m_sde->Diffusion(VMid) + ((1.0 - m_B) * m_sde->Diffusion(xn))) * std::sqrt(dt) * normalVar;
 
 		//return the result
 		return xn + driftTerm + diffusionTerm;
 	}
 };
 
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+//Concrete Derived FDM class : Exact GBM stepping in log space, GBM only
+//Typical formula is : X(n+1) = X(n) * exp((mu - q - sig^2/2)dt + sig*dW)
+class ExactGBMFDM : public IFDM
+{
+private:
+	double m_mu;			//mu - q - sig^2/2
+	double m_vol;			//sig
+	double m_driftStep;		//(mu - q - sig^2/2) * k, precomputed for the mesh size
+	double m_diffusionStep;	//sig * sqrt(k)
+public:
+	//Constructor
+	ExactGBMFDM(std::shared_ptr<GBM> stochasticEquation, int numSubdivisions) : IFDM(stochasticEquation, numSubdivisions)
+	{
+		m_vol = stochasticEquation->DiffusionCoefficient();
+		m_mu = stochasticEquation->DriftCoefficient() - stochasticEquation->Dividend() - 0.5 * m_vol * m_vol;
+		m_driftStep = m_mu * m_k;
+		m_diffusionStep = m_vol * std::sqrt(m_k);
+	}
+
+	//Getters of the per step coefficients
+	virtual double DriftStep() const final
+	{
+		return m_driftStep;
+	}
+	virtual double DiffusionStep() const final
+	{
+		return m_diffusionStep;
+	}
+
+	//Derived Advance Function
+	virtual double advance(double  xn, double  tn, double  dt, double  normalVar) override
+	{//Compute the value at tn+dt exactly, the precomputed coefficients for the mesh size
+		if (dt == m_k)
+			return xn * std::exp(m_driftStep + m_diffusionStep * normalVar);
+		return xn * std::exp(m_mu * dt + m_vol * std::sqrt(dt) * normalVar);
+	}
+
+	//Derived Derivatives Function, the drift mu - q - sig^2/2 moves with the volatility too
+	virtual bool derivatives(double  xn, double  tn, double  dt, double  normalVar, StepDerivatives& d) override
+	{
+		double sqrtDt = std::sqrt(dt);
+		double x = advance(xn, tn, dt, normalVar);
+		double s = m_vol * sqrtDt;
+		d.dx = x / xn;
+		d.dvol = x * (sqrtDt * normalVar - m_vol * dt);
+		d.dz = x * s;
+		d.dzz = x * s * s;
+		d.dzx = s * x / xn;
+		d.dzvol = d.dvol * s + x * sqrtDt;
+		return true;
+	}
+};
+
 #endif
\ No newline at end of file
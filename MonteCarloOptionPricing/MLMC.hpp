@@ -0,0 +1,317 @@
+//
+// MLMC.hpp
+//
+// Multilevel Monte Carlo driver over the Euler and Milstein FDM schemes
+//
+// A single level run needs NT ~ 1/eps steps for the bias and N ~ 1/eps^2 paths for the error, O(eps^-3) in total.
+// MLMC writes the price on the finest grid as the price on a coarse grid plus a telescoping sum of corrections
+// E[P_L] = E[P_0] + sum E[P_l - P_l-1], level l having NT_l = CoarsestSteps * 2^l steps. Each correction is estimated
+// from a fine path and a coarse path driven by the same Brownian increments (a coarse normal is the normalized sum of
+// the two fine normals of its step), so its variance falls with the level and most paths are cheap coarse ones.
+// The cost is O(eps^-2 log(eps)^2) with Euler and O(eps^-2) with Milstein, whose corrections decay faster
+//
+// MLMCDriver::start(eps, seed) follows Giles' algorithm: it adds levels until the estimated bias is below eps/sqrt(2)
+// and sets the paths of every level from the level variances so the standard error is eps/sqrt(2), so the root mean
+// square error is eps. The weak rate alpha of the corrections comes from a regression over the levels
+//
+// Every pricer's payoff is priced with the same paths, the sample counts are the largest any pricer needs. Antithetic
+// paths and control variates are not used here. The builder's NT caps the finest level. Level l draws its normals
+// from the generator's Stream(seed, l), the error estimate assumes pseudo random normals
+//
+//
+//
+
+#ifndef MLMC_HPP
+#define MLMC_HPP
+
+#include"SDE.hpp"
+#include"FDM.hpp"
+#include"RNG.hpp"
+#include"Pricer.hpp"
+#include"Builder.hpp"
+#include"Engine.hpp"
+#include<vector>
+#include<memory>
+#include<chrono>
+#include<algorithm>
+#include<iostream>
+#include<iomanip>
+#include<cmath>
+
+//Concrete MLMC driver class
+class MLMCDriver
+{
+private:
+	//Main components
+	SDEPointer m_sde;
+	FDMPointer m_fdm;						//FDM from the builder, gives the scheme and the finest NT
+	RNGPointer m_rng;
+	bool m_milstein;						//Milstein levels, otherwise Euler
+	std::vector<std::shared_ptr<IPricer>> m_pricers;
+
+	//one level of the telescoping sum
+	struct Level
+	{
+		int NT;											//steps of the fine paths
+		FDMPointer fdm;									//the scheme on NT steps
+		std::shared_ptr<IPathEngine> engine;			//its compiled kernel, null = use fdm
+		RNGPointer rng;
+		std::vector<RunningMoments> corrections;		//discounted P_l - P_l-1 (P_0 on level 0) of every pricer
+	};
+	std::vector<Level> m_levels;
+
+	//the scheme of the builder on NT steps
+	FDMPointer Scheme(int NT) const
+	{
+		if (m_milstein)
+			return std::make_shared<MilsteinFDM>(m_sde, NT);
+		return std::make_shared<EulerFDM>(m_sde, NT);
+	}
+
+	//add the next level
+	void AddLevel(unsigned long seed)
+	{
+		Level level;
+		level.NT = CoarsestSteps << m_levels.size();
+		level.fdm = Scheme(level.NT);
+		level.engine = MakeEngine(std::make_tuple(m_sde, level.fdm, m_rng));
+		level.rng = m_rng->Stream(seed, (unsigned long)(m_levels.size()));
+		level.corrections.resize(m_pricers.size());
+		m_levels.push_back(level);
+	}
+
+	//generate one path of the given level from its normals
+	void SimulatePath(Level& level, const std::vector<double>& normals, PathState& path)
+	{
+		if (level.engine)
+		{
+			level.engine->Simulate(normals, path);
+			return;
+		}
+
+		double VOld = m_sde->InitialCondition();
+		path.Start(VOld);
+		for (int n = 1; n <= level.NT; n++)
+		{
+			double VNew = level.fdm->advance(VOld, level.fdm->m_vec.back(), level.fdm->m_k, normals[n - 1]);
+			path.Add(VNew);
+			VOld = VNew;
+		}
+	}
+
+	//add count samples of the correction of level l
+	void Sample(int l, long long count)
+	{
+		Level& fine = m_levels[l];
+		std::vector<double> fineNormals(fine.NT), coarseNormals(fine.NT / 2);
+		PathState finePath, coarsePath;
+
+		for (long long i = 0; i < count; i++)
+		{
+			fine.rng->Fill(fineNormals.data(), fineNormals.size());
+			SimulatePath(fine, fineNormals, finePath);
+
+			//the coarse path takes the two fine increments of each of its steps, W(2dt) = (z1 + z2) sqrt(dt)
+			if (l > 0)
+			{
+				for (std::size_t n = 0; n < coarseNormals.size(); n++)
+				{
+					coarseNormals[n] = (fineNormals[2 * n] + fineNormals[2 * n + 1]) / std::sqrt(2.0);
+				}
+				SimulatePath(m_levels[l - 1], coarseNormals, coarsePath);
+			}
+
+			for (std::size_t k = 0; k < m_pricers.size(); ++k)
+			{
+				double correction = m_pricers[k]->Payoff(finePath);
+				if (l > 0)
+					correction -= m_pricers[k]->Payoff(coarsePath);
+				fine.corrections[k].Add(m_pricers[k]->DiscountFactor() * correction, 0.0);
+			}
+		}
+	}
+
+	//cost of one sample of level l, in steps
+	double Cost(int l) const
+	{
+		return m_levels[l].NT + (l > 0 ? m_levels[l - 1].NT : 0);
+	}
+
+	//decay rate of |values| over levels 1..L by least squares of log2, at least 0.5
+	static double Rate(const std::vector<double>& values)
+	{
+		double n = 0, sx = 0, sy = 0, sxx = 0, sxy = 0;
+		for (std::size_t l = 1; l < values.size(); l++)
+		{
+			if (values[l] <= 0)
+				continue;
+			double y = std::log2(values[l]);
+			n++;
+			sx += l;
+			sy += y;
+			sxx += double(l) * l;
+			sxy += l * y;
+		}
+		if (n < 2)
+			return 0.5;
+		double slope = (n * sxy - sx * sy) / (n * sxx - sx * sx);
+		return std::max(0.5, -slope);
+	}
+public:
+	//steps of level 0, the first coarse grid
+	static const int CoarsestSteps = 1;
+
+	//fewest levels and initial samples of a new level
+	static const int MinLevels = 3;
+	static const int InitialSamples = 10000;
+
+	//Constructor
+	MLMCDriver(BuilderTuple parts)
+	{
+		m_sde = std::get<0>(parts);
+		m_fdm = std::get<1>(parts);
+		m_rng = std::get<2>(parts);
+
+		m_milstein = bool(std::dynamic_pointer_cast<MilsteinFDM>(m_fdm));
+		if (!m_milstein && !std::dynamic_pointer_cast<EulerFDM>(m_fdm))
+			std::cout << "MLMC supports the Euler and Milstein schemes, the levels use Euler\n";
+	}
+
+	//Add a pricer
+	void AddPricer(std::shared_ptr<IPricer> p)
+	{
+		m_pricers.push_back(p);
+	}
+
+	//Start the MLMC run for a root mean square error eps on every price
+	void start(double eps, unsigned long seed)
+	{
+		if (m_pricers.empty())
+		{
+			std::cout << "MLMC simulation skipped, no pricer attached.\n";
+			return;
+		}
+
+		std::chrono::time_point <std::chrono::system_clock> start = std::chrono::system_clock::now();		//set timmer to now
+
+		//finest level allowed by the builder's NT, at least MinLevels levels
+		int maxLevels = MinLevels;
+		while ((CoarsestSteps << maxLevels) <= m_fdm->m_NT)
+			maxLevels++;
+
+		std::cout << "MLMC simulation began, target RMS error = " << eps << ", at most " << maxLevels << " levels...\n";
+
+		m_levels.clear();
+		std::vector<long long> extra;			//samples still to add on every level
+		for (int l = 0; l < MinLevels; l++)
+		{
+			AddLevel(seed);
+			extra.push_back(InitialSamples);
+		}
+
+		std::size_t P = m_pricers.size();
+		bool converged = false;
+		while (!converged)
+		{
+			for (std::size_t l = 0; l < m_levels.size(); l++)
+			{
+				Sample(int(l), extra[l]);
+			}
+
+			//level means and variances of every pricer, the means floored at half the rate they should decay by so a
+			//correction that is zero by chance does not stop the refinement
+			int L = int(m_levels.size()) - 1;
+			std::vector<std::vector<double>> means(P, std::vector<double>(L + 1)), variances(P, std::vector<double>(L + 1));
+			std::vector<double> alpha(P);
+			for (std::size_t k = 0; k < P; k++)
+			{
+				for (int l = 0; l <= L; l++)
+				{
+					means[k][l] = std::fabs(m_levels[l].corrections[k].MeanY());
+					variances[k][l] = m_levels[l].corrections[k].VarianceY();
+				}
+				alpha[k] = Rate(means[k]);
+				for (int l = 2; l <= L; l++)
+				{
+					means[k][l] = std::max(means[k][l], 0.5 * means[k][l - 1] / std::pow(2.0, alpha[k]));
+				}
+			}
+
+			//optimal samples N_l = 2/eps^2 sqrt(V_l/C_l) sum sqrt(V_k C_k), the largest over the pricers
+			std::vector<long long> optimal(L + 1, 0);
+			for (std::size_t k = 0; k < P; k++)
+			{
+				double sum = 0;
+				for (int l = 0; l <= L; l++)
+					sum += std::sqrt(variances[k][l] * Cost(l));
+				for (int l = 0; l <= L; l++)
+				{
+					long long n = (long long)(std::ceil(2.0 / (eps * eps) * std::sqrt(variances[k][l] / Cost(l)) * sum));
+					optimal[l] = std::max(optimal[l], n);
+				}
+			}
+
+			bool more = false;
+			for (int l = 0; l <= L; l++)
+			{
+				long long done = (long long)(m_levels[l].corrections[0].Count());
+				extra[l] = std::max(0LL, optimal[l] - done);
+				more = more || extra[l] > 0.01 * done;
+			}
+			if (more)
+				continue;
+
+			//the sample counts are about right, the remaining bias is estimated from the last corrections
+			bool biased = false;
+			for (std::size_t k = 0; k < P; k++)
+			{
+				double remaining = 0;
+				for (int i = 0; i < 3 && i <= L; i++)
+				{
+					remaining = std::max(remaining, means[k][L - i] / std::pow(2.0, i * alpha[k]));
+				}
+				remaining /= std::pow(2.0, alpha[k]) - 1.0;
+				biased = biased || remaining > eps / std::sqrt(2.0);
+			}
+
+			if (!biased || L + 1 >= maxLevels)
+			{
+				if (biased)
+					std::cout << "Finest level reached before the bias target, increase NT to refine further\n";
+				converged = true;
+			}
+			else
+			{
+				AddLevel(seed);
+				extra.push_back(InitialSamples);
+			}
+		}
+
+		std::cout << "Simulation completed.\n";
+		for (std::size_t l = 0; l < m_levels.size(); l++)
+		{
+			std::cout << "Level " << l << " : NT = " << m_levels[l].NT
+				<< ", Paths = " << (long long)(m_levels[l].corrections[0].Count()) << std::endl;
+		}
+
+		//price = sum of the level means, variance = sum of the level variances over their samples
+		for (std::size_t k = 0; k < P; k++)
+		{
+			double price = 0, variance = 0;
+			for (std::size_t l = 0; l < m_levels.size(); l++)
+			{
+				const RunningMoments& c = m_levels[l].corrections[k];
+				price += c.MeanY();
+				variance += c.VarianceY() / c.Count();
+			}
+			m_pricers[k]->PostProcessMultilevel(price, std::sqrt(variance), int(m_levels.size()));
+		}
+
+		//end timer
+		std::chrono::time_point <std::chrono::system_clock> end = std::chrono::system_clock::now();
+		std::chrono::duration<double> elapsed_seconds = end - start;		//calculatet the runtime
+		std::cout << "Whole process took " << elapsed_seconds.count() << "s\n";
+	}
+};
+
+#endif
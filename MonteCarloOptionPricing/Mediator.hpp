@@ -5,6 +5,43 @@
 //
 // One concrete MCMediator is created to perform all kinds of options price claculation
 //
+// start() runs every path on the calling thread, startParallel() splits the paths into fixed chunks of ChunkSize.
+// Each chunk draws from its own RNG stream (seed, chunk index) and prices into its own pricer clones, the clones
+// are merged in chunk order at the end, so a seed gives the same prices whatever the number of threads
+//
+// startRQMC() repeats the parallel run with independently scrambled generators (e.g. SobolRNG with seeds seed, seed+1..)
+// and reports the mean of the replications with their standard error in place of the path SD/SE
+//
+// Variance reduction: EnableAntithetic() prices every normal vector twice, as drawn and with its sign flipped, and the
+// pricers treat the pair as one sample. EnableControlVariate() also builds the exact GBM path from the same normals
+// (the shadow path) for pricers that were given a ControlVariate
+//
+// Paths are not stored: every step updates a PathState (last price, sums, extremes) which the pricers read once the path
+// is complete, so the memory per path is constant and a path is walked once whatever the number of pricers
+//
+// Paths are generated by the compile time MCEngine for the builder's SDE, FDM and RNG (see Engine.hpp) when there is
+// one, otherwise by the virtual IFDM advance. UseEngine(false) forces the IFDM path, both give the same prices
+//
+// With an engine the samples are simulated in blocks of SetBlockSize() paths advanced in lockstep (see PathBlock.hpp),
+// each path still draws its own NT normals in order, so the block size does not change the prices
+//
+// With the ExactGBM scheme the distribution of the terminal price does not depend on NT, so when every pricer needs
+// only the terminal price (IPricer::TerminalOnly, e.g. European books) a run simulates one exact step per path
+//
+// startAdaptive() runs batches of chunks until every pricer meets its target standard error (IPricer::SetTargetError)
+// or the path (m_NSim) or time budget is used up. The batches are sized from the errors so far, not from the number of
+// threads, so a seed still gives the same prices whatever the number of threads
+//
+// EnableContinuousMonitoring() also takes the Brownian bridge extremes between the time steps into every path's max and
+// min (PathState::AddBridged), so barriers are monitored continuously rather than at the NT points and a barrier book
+// reaches the same bias on a much coarser grid. Each path then draws four more normals per step, two for the max and two
+// for the min
+//
+// startGreeks() prices with delta, gamma and vega. When the FDM differentiates its step (IFDM::derivatives) every path
+// carries its tangents and likelihood ratio weights (PathGreeks) through the IFDM steps, so delta and vega come from the
+// same paths as the price. Gamma, and all the Greeks of the other schemes, are central differences of runs with S0 or
+// the volatility bumped, which reuse the seed so that the bumped runs see the same normals (common random numbers)
+//
 //
 //
 
@@ -16,12 +53,18 @@
 #include"RNG.hpp"
 #include"Pricer.hpp"
 #include"Builder.hpp"
+#include"Engine.hpp"
 #include<tuple>
 #include<memory>
 #include<functional>
 #include<chrono>
-#include<boost\signals2\signal.hpp> //for connecting the pricers
-#include<boost\bind.hpp>
+#include<vector>
+#include<thread>
+#include<atomic>
+#include<algorithm>
+#include<string>
+#include<cmath>
+#include<limits>
 
 //For readability
 using PricerPointer = std::shared_ptr<IPricer>;
@@ -32,73 +75,472 @@ class MCMediator
 private:
 	//Main components
 	SDEPointer m_sde;
-	FDMPointer m_fdm;
+	FDMPointer m_fdm;							//FDM of the current run
 	RNGPointer m_rng;
+	FDMPointer m_builderFdm;					//FDM from the builder, m_fdm unless a run needs only one step
+	bool m_useEngine;
+	std::shared_ptr<IPathEngine> m_engine;		//devirtualized kernel for the parts, null = use m_fdm
 
 	// Other MC-related data 
 	int m_NSim;											//number of simulations
-	std::vector<double> m_result;						//to store the generated price vector
-	boost::signals2::signal<void(const std::vector<double>&)> m_path;	//trigger pricer's process path function
-	boost::signals2::signal<void()>	m_finish;	//trigger pricer's post process function to print the result
+	std::vector<PricerPointer> m_pricers;		//attached pricers, paths are passed to them (or their clones) directly
+
+	//variance reduction settings
+	bool m_antithetic;							//price the mirrored normals too
+	bool m_controlVariate;						//build the exact GBM shadow paths
+	double m_cvDrift, m_cvVol;					//shadow GBM: r - q and volatility
+
+	bool m_greeks;								//carry the PathGreeks of every path (IFDM path only)
+	bool m_continuous;							//Brownian bridge extremes between the time steps
+
+	//buffers of one sample, each thread owns one
+	struct SampleBuffers
+	{
+		std::vector<double> normals;			//the NT normals, drawn in one Fill call
+		PathState path, shadow;					//the current path and its exact GBM shadow
+		PathGreeks greeks;						//the current path's sensitivities
+
+		SampleBuffers(int normalsPerPath) : normals(normalsPerPath) {}
+	};
+	SampleBuffers m_buffers;
+
+	//buffers of one block of samples simulated in lockstep, each thread owns one
+	struct BlockBuffers
+	{
+		std::vector<double> pathNormals;		//the normals of one path as drawn
+		AlignedVector normals;					//the block's normals, time major: normals[n * size + p]
+		PathBlock block, shadow;				//the paths and their exact GBM shadows
+		PathBlock mirror, shadowMirror;			//the antithetic mirrors, needed together with the paths to close the samples
+
+		BlockBuffers(int normalsPerPath, int size) : pathNormals(normalsPerPath), normals(std::size_t(normalsPerPath) * size),
+			block(size), shadow(size), mirror(size), shadowMirror(size) {}
+	};
+	int m_blockSize;							//paths per lockstep block, 1 = one path at a time
+
+	//continuous monitoring in this run, the Greeks' likelihood ratio weights do not cover the bridge
+	bool Bridged() const
+	{
+		return m_continuous && !m_greeks;
+	}
+
+	//normals drawn per path: the NT increments, then four per step for the bridge extremes
+	int NormalsPerPath() const
+	{
+		return Bridged() ? 5 * m_fdm->m_NT : m_fdm->m_NT;
+	}
+
+	//number of samples for m_NSim paths, an antithetic pair counts as two paths (m_NSim is even then)
+	int Samples() const
+	{
+		return m_antithetic ? m_NSim / 2 : m_NSim;
+	}
+
+	//generate one path from the given normals, and its sensitivities if greeks is not null
+	void SimulatePath(const std::vector<double>& normals, PathState& path, PathGreeks* greeks = nullptr)
+	{
+		if (m_engine && !greeks)
+		{
+			m_engine->Simulate(normals, path);
+			return;
+		}
+
+		double VOld = m_sde->InitialCondition();	//Initialize VOld with the initial price
+		path.Start(VOld);							//first price is the initial price
+		if (Bridged())
+		{
+			int NT = m_fdm->m_NT;
+			for (int n = 1; n <= NT; n++)
+			{
+				//log variance of the step from the local volatility at its start
+				double s = m_sde->Diffusion(VOld) / VOld;
+				double VNew = m_fdm->advance(VOld, m_fdm->m_vec.back(), m_fdm->m_k, normals[n - 1]);
+				const double* e = &normals[NT + 4 * (n - 1)];
+				path.AddBridged(VNew, s * s * m_fdm->m_k, PathState::Exponential(e[0], e[1]), PathState::Exponential(e[2], e[3]));
+				VOld = VNew;
+			}
+			return;
+		}
+		if (greeks)
+		{
+			greeks->delta.Start(1.0, VOld);
+			greeks->vega.Start(0.0, VOld);
+			greeks->deltaWeight = 0.0;
+			greeks->vegaWeight = 0.0;
+		}
+
+		//generate price on the NT time intervals
+		for (int n = 1; n <= (m_fdm->m_NT); n++)
+		{
+			//calling advance function to generate the price on the next time interval
+			double VNew = m_fdm->advance(VOld, m_fdm->m_vec.back(), m_fdm->m_k, normals[n - 1]);
+			path.Add(VNew);	//update the running values
+			if (greeks)
+				AddStepGreeks(*greeks, n, VOld, VNew, normals[n - 1]);
+			VOld = VNew;
+		}
+	}
+
+	//carry the sensitivities through step n from VOld to VNew
+	void AddStepGreeks(PathGreeks& greeks, int n, double VOld, double VNew, double normalVar)
+	{
+		StepDerivatives d;
+		m_fdm->derivatives(VOld, m_fdm->m_vec.back(), m_fdm->m_k, normalVar, d);
+
+		//pathwise: chain rule through the step
+		greeks.delta.Add(d.dx * greeks.delta.last, VNew);
+		greeks.vega.Add(d.dx * greeks.vega.last + d.dvol, VNew);
+
+		//likelihood ratio: only the first step's density depends on S0, every step's depends on the volatility
+		if (n == 1)
+			greeks.deltaWeight = d.Score(d.dx, d.dzx, normalVar);
+		greeks.vegaWeight += d.Score(d.dvol, d.dzvol, normalVar);
+	}
+
+	//exact GBM path from the same normals, S(n+1) = S(n) * exp((r - q - vol^2/2) dt + vol sqrt(dt) z)
+	void SimulateShadow(const std::vector<double>& normals, PathState& shadow)
+	{
+		double dt = m_fdm->m_k;
+		double drift = (m_cvDrift - 0.5 * m_cvVol * m_cvVol) * dt;
+		double diffusion = m_cvVol * std::sqrt(dt);
+
+		double S = m_sde->InitialCondition();
+		shadow.Start(S);
+		for (int n = 0; n < m_fdm->m_NT; n++)
+		{
+			S *= std::exp(drift + diffusion * normals[n]);
+			shadow.Add(S);
+		}
+	}
+
+	//draw one sample (a path, or an antithetic pair) and pass it to the pricers
+	void SimulateSample(IRNG& rng, SampleBuffers& b, const std::vector<PricerPointer>& pricers)
+	{
+		if (m_engine)
+			m_engine->Normals(rng, b.normals);
+		else
+			rng.Fill(b.normals.data(), b.normals.size());
+
+		PathGreeks* greeks = m_greeks ? &b.greeks : nullptr;
+		SimulatePath(b.normals, b.path, greeks);
+		if (m_controlVariate)
+			SimulateShadow(b.normals, b.shadow);
+		for (auto it = pricers.begin(); it != pricers.end(); ++it)
+		{
+			(*it)->AddPath(b.path, m_controlVariate ? &b.shadow : nullptr, greeks);
+		}
+
+		if (m_antithetic)
+		{
+			for (auto it = b.normals.begin(); it != b.normals.end(); ++it)
+			{
+				*it = -*it;
+			}
+
+			SimulatePath(b.normals, b.path, greeks);
+			if (m_controlVariate)
+				SimulateShadow(b.normals, b.shadow);
+			for (auto it = pricers.begin(); it != pricers.end(); ++it)
+			{
+				(*it)->AddPath(b.path, m_controlVariate ? &b.shadow : nullptr, greeks);
+			}
+		}
+
+		for (auto it = pricers.begin(); it != pricers.end(); ++it)
+		{
+			(*it)->CloseSample();
+		}
+	}
+
+	//exact GBM shadows of a block, lane p uses the same normals as path p
+	void SimulateShadowBlock(const double* normals, int size, PathBlock& shadow)
+	{
+		double dt = m_fdm->m_k;
+		double drift = (m_cvDrift - 0.5 * m_cvVol * m_cvVol) * dt;
+		double diffusion = m_cvVol * std::sqrt(dt);
+
+		shadow.Start(m_sde->InitialCondition(), size);
+		for (int n = 0; n < m_fdm->m_NT; n++)
+		{
+			const double* z = normals + std::size_t(n) * size;
+			shadow.Advance(size, [&](int p, double S) { return S * std::exp(drift + diffusion * z[p]); });
+		}
+	}
+
+	//draw size samples in lockstep and pass them to the pricers, same samples in the same order as SimulateSample
+	void SimulateBlock(IRNG& rng, BlockBuffers& b, int size, const std::vector<PricerPointer>& pricers)
+	{
+		int rows = int(b.pathNormals.size());
+		for (int p = 0; p < size; p++)
+		{
+			m_engine->Normals(rng, b.pathNormals);
+			for (int n = 0; n < rows; n++)
+				b.normals[std::size_t(n) * size + p] = b.pathNormals[n];
+		}
+
+		m_engine->SimulateBlock(b.normals.data(), size, b.block);
+		if (m_controlVariate)
+			SimulateShadowBlock(b.normals.data(), size, b.shadow);
+
+		if (m_antithetic)
+		{
+			double* z = b.normals.data();
+			std::size_t count = std::size_t(rows) * size;
+#pragma omp simd
+			for (std::size_t i = 0; i < count; i++)
+				z[i] = -z[i];
+
+			m_engine->SimulateBlock(z, size, b.mirror);
+			if (m_controlVariate)
+				SimulateShadowBlock(z, size, b.shadowMirror);
+		}
+
+		//the pricers' accumulators are updated lane by lane
+		for (int p = 0; p < size; p++)
+		{
+			PathState path = b.block.State(p), shadow = b.shadow.State(p);
+			for (auto it = pricers.begin(); it != pricers.end(); ++it)
+			{
+				(*it)->AddPath(path, m_controlVariate ? &shadow : nullptr);
+			}
+
+			if (m_antithetic)
+			{
+				PathState mirror = b.mirror.State(p), shadowMirror = b.shadowMirror.State(p);
+				for (auto it = pricers.begin(); it != pricers.end(); ++it)
+				{
+					(*it)->AddPath(mirror, m_controlVariate ? &shadowMirror : nullptr);
+				}
+			}
+
+			for (auto it = pricers.begin(); it != pricers.end(); ++it)
+			{
+				(*it)->CloseSample();
+			}
+		}
+	}
+
+	//number of samples simulated together, a block with an engine, otherwise one
+	int Step() const
+	{
+		return (m_engine && m_blockSize > 1) ? m_blockSize : 1;
+	}
+
+	//simulate the next count samples (at most Step()) with the given generator and buffers
+	void SimulateSamples(IRNG& rng, int count, SampleBuffers& buffers, std::unique_ptr<BlockBuffers>& blocks, const std::vector<PricerPointer>& pricers)
+	{
+		if (Step() > 1)
+		{
+			if (!blocks)
+				blocks.reset(new BlockBuffers(NormalsPerPath(), m_blockSize));
+			SimulateBlock(rng, *blocks, count, pricers);
+		}
+		else
+		{
+			for (int i = 0; i < count; ++i)
+			{
+				SimulateSample(rng, buffers, pricers);
+			}
+		}
+	}
+
+	//simulate all m_NSim paths in chunks on numberThreads threads and merge the chunk results into the given pricers
+	void RunChunks(int numberThreads, unsigned long seed, const std::vector<PricerPointer>& into)
+	{
+		int samples = Samples();
+		RunChunks(numberThreads, seed, into, 0, (samples + ChunkSize - 1) / ChunkSize, samples);
+	}
+
+	//simulate chunks [firstChunk, lastChunk) of a run of samples samples
+	void RunChunks(int numberThreads, unsigned long seed, const std::vector<PricerPointer>& into, int firstChunk, int lastChunk, int samples)
+	{
+		int chunks = lastChunk - firstChunk;
+		std::vector<std::vector<PricerPointer>> results(chunks);	//pricer clones of every chunk
+		std::atomic<int> next(firstChunk);
+
+		auto worker = [&]()
+		{
+			SampleBuffers buffers(NormalsPerPath());	//owned by this thread
+			std::unique_ptr<BlockBuffers> blocks;
+
+			for (int c = next++; c < lastChunk; c = next++)
+			{
+				RNGPointer rng = m_rng->Stream(seed, c);
+				std::vector<PricerPointer>& result = results[c - firstChunk];
+				for (auto it = into.begin(); it != into.end(); ++it)
+				{
+					result.push_back((*it)->Clone());
+				}
+
+				int end = std::min(samples, (c + 1) * ChunkSize);
+				for (int i = c * ChunkSize; i < end; i += Step())
+				{
+					SimulateSamples(*rng, std::min(Step(), end - i), buffers, blocks, result);
+				}
+			}
+		};
+
+		std::vector<std::thread> pool;
+		for (int t = 1; t < numberThreads && t < chunks; ++t)
+		{
+			pool.push_back(std::thread(worker));
+		}
+		worker();
+		for (auto it = pool.begin(); it != pool.end(); ++it)
+		{
+			it->join();
+		}
+
+		//merge in chunk order so the sums do not depend on which thread ran which chunk
+		for (int c = 0; c < chunks; ++c)
+		{
+			for (std::size_t k = 0; k < into.size(); ++k)
+			{
+				into[k]->Merge(*results[c][k]);
+			}
+		}
+	}
+
+	//choose the FDM of the run: one exact step per path when the scheme is exact and every pricer needs only the
+	//terminal price, otherwise the builder's FDM with its NT steps
+	void Prepare()
+	{
+		bool terminal = !m_pricers.empty();
+		for (auto it = m_pricers.begin(); it != m_pricers.end(); ++it)
+		{
+			terminal = terminal && (*it)->TerminalOnly();
+		}
+
+		m_fdm = m_builderFdm;
+		if (terminal && m_builderFdm->m_NT > 1 && std::dynamic_pointer_cast<ExactGBMFDM>(m_builderFdm))
+		{
+			std::cout << "Only terminal prices are needed, simulating one exact step per path\n";
+			m_fdm = std::make_shared<ExactGBMFDM>(std::static_pointer_cast<GBM>(m_builderFdm->StochasticEquation()), 1);
+		}
+
+		//the Greeks need the IFDM steps, and the engine's copy of the SDE would not see the bumps
+		m_engine = (m_useEngine && !m_greeks) ? MakeEngine(std::make_tuple(m_sde, m_fdm, m_rng)) : nullptr;
+		if (m_engine)
+			m_engine->ContinuousMonitoring(Bridged());
+		m_rng->PathLength(m_fdm->m_NT);		//the bridge extremes come after the increments
+		m_buffers.normals.resize(NormalsPerPath());
+	}
+
+	//rerun the paths of the seed (the same normals) into clones of the pricers, for bump and revalue
+	std::vector<PricerPointer> Revalue(int numberThreads, unsigned long seed)
+	{
+		std::vector<PricerPointer> clones;
+		for (auto it = m_pricers.begin(); it != m_pricers.end(); ++it)
+		{
+			clones.push_back((*it)->Clone());
+		}
+		RunChunks(numberThreads, seed, clones);
+		return clones;
+	}
+
+	//post process of every pricer
+	void Finish()
+	{
+		for (auto it = m_pricers.begin(); it != m_pricers.end(); ++it)
+		{
+			(*it)->PostProcess();
+		}
+	}
 public:
+	//number of samples per parallel work item, fixed so the split does not depend on the thread count
+	static const int ChunkSize = 1024;
+
+	//smallest batch of an adaptive run, in chunks
+	static const int MinBatchChunks = 8;
+
+	//default number of paths advanced in lockstep, the lanes' states stay in the L1 cache
+	static const int DefaultBlockSize = 256;
+
 	//Constructor
 	MCMediator(BuilderTuple parts, int numberSimulations)
+		: m_antithetic(false), m_controlVariate(false), m_cvDrift(0.0), m_cvVol(0.0), m_greeks(false), m_continuous(false), m_buffers(std::get<1>(parts)->m_NT),
+		m_blockSize(DefaultBlockSize)
 	{
 		//Assign the SDE,FDM and RNG from the builder
 		m_sde = std::get<0>(parts);
 		m_fdm = std::get<1>(parts);
 		m_rng = std::get<2>(parts);
+		m_builderFdm = m_fdm;
+		m_useEngine = true;
+		m_engine = MakeEngine(parts);
 
 		m_NSim = numberSimulations;	//assign the number of simulations
+	}
+
+	//Generate the paths with the compile time engine(default) or the virtual IFDM classes
+	void UseEngine(bool on)
+	{
+		m_useEngine = on;
+		m_engine = on ? MakeEngine(std::make_tuple(m_sde, m_fdm, m_rng)) : nullptr;
+	}
+
+	//Number of paths simulated in lockstep by the engine, 1 = one path at a time
+	void SetBlockSize(int size)
+	{
+		m_blockSize = std::max(1, size);
+	}
 
-		m_result.resize(m_fdm->m_NT + 1);	//resize the final price vector
+	//Price pairs of mirrored paths, m_NSim then counts both paths of a pair and an odd m_NSim is rounded up
+	void EnableAntithetic(bool on)
+	{
+		m_antithetic = on;
+		if (m_antithetic && m_NSim % 2 != 0)
+		{
+			m_NSim++;
+			std::cout << "Antithetic paths come in pairs, the number of simulations is rounded up to " << m_NSim << std::endl;
+		}
+	}
+
+	//Build the exact GBM shadow of every path for the pricers' control variates
+	void EnableControlVariate(double rate, double vol, double div)
+	{
+		m_controlVariate = true;
+		m_cvDrift = rate - div;
+		m_cvVol = vol;
+	}
+
+	//Monitor the barriers continuously: the paths' max and min also take the Brownian bridge between the time steps
+	void EnableContinuousMonitoring(bool on)
+	{
+		m_continuous = on;
 	}
 
-	//Add a pricer to the signal
+	//Add a pricer
 	void AddPricer(PricerPointer p)
 	{
-		//Connect the pricer's ProcessPath and PostProcess functions to the signals
-		m_path.connect(boost::bind(&IPricer::ProcessPath, boost::ref(*p), boost::placeholders::_1));
-		m_finish.connect(boost::bind(&(IPricer::PostProcess), boost::ref(*p)));
+		m_pricers.push_back(p);
 	}
 
-	//remove a pricer from the signal
+	//remove a pricer
 	void RemovePricer(PricerPointer p)
 	{
-		//Remove the functions from signal
-		m_path.disconnect(boost::bind(&IPricer::ProcessPath, boost::ref(*p), boost::placeholders::_1));
-		m_finish.disconnect(boost::bind(&(IPricer::PostProcess), boost::ref(*p)));
+		m_pricers.erase(std::remove(m_pricers.begin(), m_pricers.end(), p), m_pricers.end());
 	}
 
 	//Main algorithm
 	//Start Price Calculation
 	void start()
 	{
-		double VOld, VNew;
 		double percentage_complete = 0;		//for displaying the progress
 
 		std::chrono::time_point <std::chrono::system_clock> start = std::chrono::system_clock::now();		//set timmer to now
 
 		std::cout << "Simulation began...\n";
+		Prepare();
 
-		for (int i = 1; i <= m_NSim; ++i)
+		int samples = Samples();
+		std::unique_ptr<BlockBuffers> blocks;
+		for (int i = 0; i < samples; i += Step())
 		{
-			VOld = m_sde->InitialCondition();	//Initialize VOld with the initial price
-			m_result[0] = VOld;					//first price is the initial price
-
-												//generate price on the NT time intervals
-			for (int n = 1; n <= (m_fdm->m_NT); n++)
-			{
-				//calling advance function to generate the price on the next time interval
-				VNew = m_fdm->advance(VOld, m_fdm->m_vec.back(), m_fdm->m_k, m_rng->GenerateRng());
-				m_result[n] = VNew;	//set the price vector
-				VOld = VNew;
-			}
-
-			m_path(m_result);	// Send path data to the Pricers
+			int count = std::min(Step(), samples - i);
+			SimulateSamples(*m_rng, count, m_buffers, blocks, m_pricers);	// Send path data to the Pricers
 
 								//display the progress in %
-			double completed = i / (m_NSim*1.0);
+			double completed = (i + count) / (samples*1.0);
 			if (completed > percentage_complete)
 			{
 				std::cout << int(completed * 100) << "%.";
@@ -107,13 +549,219 @@ public:
 		}
 		std::cout << "\nSimulation completed.\n";
 
-		m_finish();  // Signal the pricers to perform the post process and display the price, SD and SE.
+		Finish();	// the pricers perform the post process and display the price, SD and SE.
 
 					 //end timer
 		std::chrono::time_point <std::chrono::system_clock> end = std::chrono::system_clock::now();
 		std::chrono::duration<double> elapsed_seconds = end - start;		//calculatet the runtime
 		std::cout << "Whole process took " << elapsed_seconds.count() << "s\n";
 	}
+
+	//Start Price Calculation on numberThreads threads (0 = all hardware threads)
+	void startParallel(int numberThreads, unsigned long seed)
+	{
+		if (numberThreads <= 0)
+			numberThreads = std::max(1, int(std::thread::hardware_concurrency()));
+
+		std::chrono::time_point <std::chrono::system_clock> start = std::chrono::system_clock::now();		//set timmer to now
+
+		std::cout << "Simulation began on " << numberThreads << " threads...\n";
+		Prepare();
+
+		RunChunks(numberThreads, seed, m_pricers);
+		std::cout << "Simulation completed.\n";
+
+		Finish();	// the pricers perform the post process and display the price, SD and SE.
+
+		//end timer
+		std::chrono::time_point <std::chrono::system_clock> end = std::chrono::system_clock::now();
+		std::chrono::duration<double> elapsed_seconds = end - start;		//calculatet the runtime
+		std::cout << "Whole process took " << elapsed_seconds.count() << "s\n";
+	}
+
+	//Start randomized QMC: replications independent runs of m_NSim paths, replication r uses seed + r
+	//Meant for scrambled quasi random generators, the error estimate is the spread of the replication prices
+	void startRQMC(int replications, unsigned long seed, int numberThreads = 1)
+	{
+		if (numberThreads <= 0)
+			numberThreads = std::max(1, int(std::thread::hardware_concurrency()));
+
+		std::chrono::time_point <std::chrono::system_clock> start = std::chrono::system_clock::now();		//set timmer to now
+
+		std::cout << "Simulation began, " << replications << " replications of " << m_NSim << " paths...\n";
+		Prepare();
+
+		std::vector<std::vector<double>> estimates(m_pricers.size());	//price of every replication for every pricer
+		for (int r = 0; r < replications; ++r)
+		{
+			std::vector<PricerPointer> replication;
+			for (auto it = m_pricers.begin(); it != m_pricers.end(); ++it)
+			{
+				replication.push_back((*it)->Clone());
+			}
+
+			RunChunks(numberThreads, seed + r, replication);
+
+			for (std::size_t k = 0; k < m_pricers.size(); ++k)
+			{
+				estimates[k].push_back(replication[k]->Estimate());
+				m_pricers[k]->Merge(*replication[k]);
+			}
+		}
+		std::cout << "Simulation completed.\n";
+
+		for (std::size_t k = 0; k < m_pricers.size(); ++k)
+		{
+			m_pricers[k]->PostProcessReplications(estimates[k]);
+		}
+
+		//end timer
+		std::chrono::time_point <std::chrono::system_clock> end = std::chrono::system_clock::now();
+		std::chrono::duration<double> elapsed_seconds = end - start;		//calculatet the runtime
+		std::cout << "Whole process took " << elapsed_seconds.count() << "s\n";
+	}
+
+	//Start an adaptive run: batches of chunks until every pricer meets its target standard error, at most m_NSim paths
+	//and maxSeconds seconds (0 = no time budget), on numberThreads threads (0 = all hardware threads)
+	void startAdaptive(unsigned long seed, double maxSeconds = 0, int numberThreads = 1)
+	{
+		if (numberThreads <= 0)
+			numberThreads = std::max(1, int(std::thread::hardware_concurrency()));
+
+		std::chrono::time_point <std::chrono::system_clock> start = std::chrono::system_clock::now();		//set timmer to now
+
+		std::cout << "Adaptive simulation began on " << numberThreads << " threads, at most " << m_NSim << " paths...\n";
+		Prepare();
+
+		int samples = Samples();
+		int budget = (samples + ChunkSize - 1) / ChunkSize;		//chunks in the path budget
+		int done = 0, batch = MinBatchChunks, batches = 0;
+		std::string reason = "path budget reached";
+		while (done < budget)
+		{
+			int last = std::min(budget, done + batch);
+			RunChunks(numberThreads, seed, m_pricers, done, last, samples);
+			done = last;
+			batches++;
+
+			bool met = true;
+			double ratio = 0;
+			for (auto it = m_pricers.begin(); it != m_pricers.end(); ++it)
+			{
+				met = met && (*it)->TargetMet();
+				ratio = std::max(ratio, (*it)->TargetRatio());
+			}
+			if (met)
+			{
+				reason = "all targets met";
+				break;
+			}
+
+			std::chrono::duration<double> elapsed = std::chrono::system_clock::now() - start;
+			if (maxSeconds > 0 && elapsed.count() >= maxSeconds)
+			{
+				reason = "time budget reached";
+				break;
+			}
+
+			//the standard error falls as 1/sqrt(n): the run needs about ratio times its samples, the next batch
+			//covers the missing ones with a 10% margin, at least MinBatchChunks and at most doubling the run
+			double missing = (ratio - 1.0) * done * 1.1;
+			batch = std::max(MinBatchChunks, int(std::min<double>(done, std::ceil(missing))));
+		}
+
+		long long paths = m_pricers.empty() ? 0 : m_pricers.front()->Paths();
+		std::cout << "Simulation completed, " << reason << " after " << paths << " paths in " << batches << " batches.\n";
+
+		Finish();	// the pricers perform the post process and display the price, SD and SE.
+
+		//end timer
+		std::chrono::time_point <std::chrono::system_clock> end = std::chrono::system_clock::now();
+		std::chrono::duration<double> elapsed_seconds = end - start;		//calculatet the runtime
+		std::cout << "Whole process took " << elapsed_seconds.count() << "s\n";
+	}
+
+	//Start Price Calculation with delta, gamma and vega, on numberThreads threads (0 = all hardware threads)
+	//bump is the relative bump of S0 (and of the volatility when the scheme has no step derivatives)
+	void startGreeks(int numberThreads, unsigned long seed, double bump = 0.01)
+	{
+		if (numberThreads <= 0)
+			numberThreads = std::max(1, int(std::thread::hardware_concurrency()));
+
+		std::chrono::time_point <std::chrono::system_clock> start = std::chrono::system_clock::now();		//set timmer to now
+
+		std::cout << "Simulation with Greeks began on " << numberThreads << " threads...\n";
+		m_greeks = true;
+		Prepare();
+
+		//without step derivatives every run is bumped and revalued, so the bridge monitoring stays on
+		StepDerivatives probe;
+		bool pathwise = m_fdm->derivatives(m_sde->InitialCondition(), 0.0, m_fdm->m_k, 0.0, probe);
+		m_greeks = pathwise;
+		if (m_continuous && pathwise)
+			std::cout << "The Greeks runs monitor the barriers at the NT points only\n";
+
+		RunChunks(numberThreads, seed, m_pricers);
+
+		//S0 bumped runs with the same normals, and the volatility bumped ones if the paths carry no sensitivities
+		double S0 = m_sde->InitialCondition(), h = bump * S0;
+		m_sde->InitialCondition(S0 + h);
+		std::vector<PricerPointer> up = Revalue(numberThreads, seed);
+		m_sde->InitialCondition(S0 - h);
+		std::vector<PricerPointer> down = Revalue(numberThreads, seed);
+		m_sde->InitialCondition(S0);
+
+		double vol = m_sde->Volatility(), hv = bump * vol;
+		std::vector<PricerPointer> volUp, volDown;
+		if (!pathwise)
+		{
+			m_sde->Volatility(vol + hv);
+			volUp = Revalue(numberThreads, seed);
+			m_sde->Volatility(vol - hv);
+			volDown = Revalue(numberThreads, seed);
+			m_sde->Volatility(vol);
+		}
+		m_greeks = false;
+		std::cout << "Simulation completed.\n";
+
+		Finish();	// the pricers perform the post process and display the price, SD and SE.
+
+		for (std::size_t k = 0; k < m_pricers.size(); ++k)
+		{
+			//a Greek stays NaN (printed N/A) when a run behind it has too few samples
+			double delta = std::numeric_limits<double>::quiet_NaN(), gamma = delta, vega = delta;
+			std::string method;
+			if (pathwise)
+			{
+				//gamma is the central difference of the bumped deltas
+				double deltaUp = 0.0, deltaDown = 0.0, unused = 0.0;
+				if (!m_pricers[k]->GreekEstimates(delta, unused, vega, unused))
+					delta = vega = std::numeric_limits<double>::quiet_NaN();
+				if (up[k]->GreekEstimates(deltaUp, unused, unused, unused) && down[k]->GreekEstimates(deltaDown, unused, unused, unused))
+					gamma = (deltaUp - deltaDown) / (2.0 * h);
+				method = m_pricers[k]->LikelihoodRatio() ? "likelihood ratio" : "pathwise";
+			}
+			else
+			{
+				//the plain path means, the control variate means hold only for the unbumped inputs
+				double price = m_pricers[k]->Estimate(false);
+				double priceUp = up[k]->Estimate(false), priceDown = down[k]->Estimate(false);
+				if (up[k]->Paths() > 0 && down[k]->Paths() > 0)
+					delta = (priceUp - priceDown) / (2.0 * h);
+				if (m_pricers[k]->Paths() > 0 && up[k]->Paths() > 0 && down[k]->Paths() > 0)
+					gamma = (priceUp - 2.0 * price + priceDown) / (h * h);
+				if (volUp[k]->Paths() > 0 && volDown[k]->Paths() > 0)
+					vega = (volUp[k]->Estimate(false) - volDown[k]->Estimate(false)) / (2.0 * hv);
+				method = "bump and revalue";
+			}
+			m_pricers[k]->PostProcessGreeks(delta, gamma, vega, method);
+		}
+
+		//end timer
+		std::chrono::time_point <std::chrono::system_clock> end = std::chrono::system_clock::now();
+		std::chrono::duration<double> elapsed_seconds = end - start;		//calculatet the runtime
+		std::cout << "Whole process took " << elapsed_seconds.count() << "s\n";
+	}
 };
 
 #endif
\ No newline at end of file
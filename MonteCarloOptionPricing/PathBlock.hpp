@@ -0,0 +1,186 @@
+//
+// PathBlock.hpp
+//
+// Running states of a block of paths simulated in lockstep, one time step for every path at a time
+//
+// The states are kept as a structure of arrays (one aligned array per PathState member, one lane per path) so the
+// step of all the lanes is one vectorized loop. State(p) gives lane p back as a PathState for the pricers
+//
+// AlignedAllocator : std::vector allocator returning 64 byte aligned storage
+// PathBlock : the SoA states, Advance(size, step) moves every lane one time step, AdvanceBridged also takes the extremes
+//		of the Brownian bridge of each step into the max and min (continuous monitoring, see PathState::AddBridged)
+//
+//
+//
+
+#ifndef PATH_BLOCK_HPP
+#define PATH_BLOCK_HPP
+
+#include"Pricer.hpp"
+#include<vector>
+#include<cstdlib>
+#include<cstdint>
+#include<new>
+#include<algorithm>
+#include<cmath>
+
+//Allocator aligning the storage to Alignment bytes (a cache line), so the lanes start on a vector boundary
+template<class T, std::size_t Alignment = 64>
+struct AlignedAllocator
+{
+	typedef T value_type;
+	template<class U> struct rebind { typedef AlignedAllocator<U, Alignment> other; };
+
+	AlignedAllocator() {}
+	template<class U> AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+	T* allocate(std::size_t n)
+	{
+		//over allocate, the original pointer is kept just in front of the aligned block
+		void* raw = std::malloc(n * sizeof(T) + Alignment + sizeof(void*));
+		if (!raw)
+			throw std::bad_alloc();
+		std::uintptr_t aligned = (reinterpret_cast<std::uintptr_t>(raw) + sizeof(void*) + Alignment - 1) & ~std::uintptr_t(Alignment - 1);
+		reinterpret_cast<void**>(aligned)[-1] = raw;
+		return reinterpret_cast<T*>(aligned);
+	}
+
+	void deallocate(T* p, std::size_t)
+	{
+		std::free(reinterpret_cast<void**>(p)[-1]);
+	}
+};
+
+template<class T, class U, std::size_t A>
+bool operator==(const AlignedAllocator<T, A>&, const AlignedAllocator<U, A>&) { return true; }
+template<class T, class U, std::size_t A>
+bool operator!=(const AlignedAllocator<T, A>&, const AlignedAllocator<U, A>&) { return false; }
+
+using AlignedVector = std::vector<double, AlignedAllocator<double>>;
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+//Structure of arrays of PathStates, every lane is updated exactly like PathState::Add
+class PathBlock
+{
+private:
+	double m_first;		//initial price, the same for every lane
+	int m_points;		//number of prices so far, the same for every lane
+	AlignedVector m_last, m_sum, m_logSum, m_product, m_max, m_min;
+
+	//a product left the range, rare so it is handled after the vector loop
+	void Fold(int size)
+	{
+		int fold = 0;
+		for (int p = 0; p < size; p++)
+			fold |= !PathState::InRange(m_product[p]);
+		if (fold)
+		{
+			for (int p = 0; p < size; p++)
+			{
+				if (!PathState::InRange(m_product[p]))
+				{
+					m_logSum[p] += std::log(m_product[p]);
+					m_product[p] = 1.0;
+				}
+			}
+		}
+	}
+public:
+	//Constructor
+	PathBlock(int capacity = 0) : m_first(0.0), m_points(0), m_last(capacity), m_sum(capacity), m_logSum(capacity),
+		m_product(capacity), m_max(capacity), m_min(capacity) {}
+
+	//start size lanes at the initial price
+	void Start(double S0, int size)
+	{
+		m_first = S0;
+		m_points = 1;
+		std::fill(m_last.begin(), m_last.begin() + size, S0);
+		std::fill(m_sum.begin(), m_sum.begin() + size, S0);
+		std::fill(m_logSum.begin(), m_logSum.begin() + size, 0.0);
+		std::fill(m_product.begin(), m_product.begin() + size, S0);
+		std::fill(m_max.begin(), m_max.begin() + size, S0);
+		std::fill(m_min.begin(), m_min.begin() + size, S0);
+	}
+
+	//move every lane one time step, step(p, x) returns lane p's next price from its current price x
+	template<class Step>
+	void Advance(int size, Step step)
+	{
+		double* last = m_last.data();
+		double* sum = m_sum.data();
+		double* product = m_product.data();
+		double* max = m_max.data();
+		double* min = m_min.data();
+
+#pragma omp simd
+		for (int p = 0; p < size; p++)
+		{
+			double x = step(p, last[p]);
+			last[p] = x;
+			sum[p] += x;
+			product[p] *= x;
+			//running extremes as plain selects on the lane values
+			double mx = max[p], mn = min[p];
+			max[p] = x > mx ? x : mx;
+			min[p] = x < mn ? x : mn;
+		}
+
+		Fold(size);
+		m_points++;
+	}
+
+	//Advance with the extremes of the Brownian bridge of the step, variance(p, x) is lane p's log variance of the step
+	//from its current price x, z[p] and z[size + p] the normals of its exponential draw for the max, z[2 size + p] and
+	//z[3 size + p] those for the min
+	template<class Step, class Variance>
+	void AdvanceBridged(int size, Step step, Variance variance, const double* z)
+	{
+		double* last = m_last.data();
+		double* sum = m_sum.data();
+		double* product = m_product.data();
+		double* max = m_max.data();
+		double* min = m_min.data();
+
+#pragma omp simd
+		for (int p = 0; p < size; p++)
+		{
+			double x0 = last[p];
+			double x = step(p, x0);
+			double top, bottom;
+			PathState::BridgeExtremes(x0, x, variance(p, x0), PathState::Exponential(z[p], z[size + p]),
+				PathState::Exponential(z[2 * size + p], z[3 * size + p]), top, bottom);
+			last[p] = x;
+			sum[p] += x;
+			product[p] *= x;
+			//by value, as in Advance
+			double mx = max[p], mn = min[p];
+			max[p] = top > mx ? top : mx;
+			min[p] = bottom < mn ? bottom : mn;
+		}
+
+		Fold(size);
+		m_points++;
+	}
+
+	//lane p as a PathState
+	PathState State(int p) const
+	{
+		PathState state;
+		state.first = m_first;
+		state.last = m_last[p];
+		state.sum = m_sum[p];
+		state.logSum = m_logSum[p];
+		state.product = m_product[p];
+		state.max = m_max[p];
+		state.min = m_min[p];
+		state.points = m_points;
+		return state;
+	}
+};
+
+#endif
@@ -7,6 +7,23 @@
 //	One Base class : IPricer
 //  Three Derived classes : EuropeanPricer, AsianPricer and BarrierPricer
 //
+// Paths arrive as a PathState: the running values (last price, sum, log sum, max and min) that the mediator updates once
+// per time step, so a path is walked once and no pricer keeps or rescans the price vector. With continuous monitoring
+// (AddBridged) the max and min also cover the Brownian bridge between the time steps, so the knock functions see the
+// barrier crossings a grid point check misses
+//
+// Paths arrive in samples: one path, or an antithetic pair (AddPath for each path, then CloseSample). A pricer with a
+// ControlVariate also receives the exact GBM shadow of every path, built from the same normals by the mediator, and
+// reports the control variate corrected price next to the plain one
+//
+// The moments are accumulated in batches of deviations from a shift and combined with Chan's formula (RunningMoments)
+// rather than as plain sums of squares, so the standard errors do not cancel away. SetTargetError gives the pricer a target standard
+// error for MCMediator::startAdaptive
+//
+// Greeks: with a PathGreeks (MCMediator::startGreeks) a pricer also accumulates delta and vega in the same pass. Smooth
+// payoffs use the pathwise derivative, the payoff differentiated along the path's tangent; barrier payoffs, and any
+// pricer set to UseLikelihoodRatio (e.g. digital payoffs), weight the payoff with the likelihood ratio of the path
+//
 //
 //
 
@@ -19,10 +36,235 @@
 #include<iostream>
 #include<functional>
 #include<iomanip>	//format output
+#include<memory>
+#include<string>
+#include<cmath>
 
 // The payoff function - input a double(Stock price) and return a double(the payoff)
 using PayoffFunction = std::function<double(const double&)>;
 
+// Running state of one path, O(1) memory whatever the number of time steps
+struct PathState
+{
+	double first = 0.0;				//initial price
+	double last = 0.0;				//latest price
+	double sum = 0.0;				//sum of the prices so far, for arithmetic averages
+	double logSum = 0.0;			//log of the prices folded out of product, read the total with LogSum()
+	double product = 1.0;			//product of the prices since the last fold
+	double max = 0.0, min = 0.0;	//running extremes, for barriers
+	int points = 0;					//number of prices so far, NT+1 for a full path
+
+	//start a new path at the initial price
+	void Start(double S0)
+	{
+		first = last = sum = max = min = product = S0;
+		logSum = 0.0;
+		points = 1;
+	}
+
+	//add the price of the next time step
+	//the product is folded into logSum before it can overflow, so there is no log call on most steps
+	void Add(double S)
+	{
+		last = S;
+		sum += S;
+		product *= S;
+		if (!InRange(product))
+		{
+			logSum += std::log(product);
+			product = 1.0;
+		}
+		max = std::max(max, S);
+		min = std::min(min, S);
+		points++;
+	}
+
+	//add the next price, with the extremes of the Brownian bridge between the two prices (continuous monitoring)
+	//variance is the log variance of the step (local volatility^2 * dt), eMax and eMin independent exponential draws
+	void AddBridged(double S, double variance, double eMax, double eMin)
+	{
+		double top, bottom;
+		BridgeExtremes(last, S, variance, eMax, eMin, top, bottom);
+		Add(S);
+		max = std::max(max, top);
+		min = std::min(min, bottom);
+	}
+
+	//maximum and minimum of the Brownian bridge of the log price from x0 to x1 over a step of log variance v, sampled by
+	//inverting P(max > H) = exp(-2 ln(H/x0) ln(H/x1) / v), the probability that a barrier H was crossed between the two
+	//points: max = exp((a + b + sqrt((b - a)^2 + 2 v e)) / 2) with a, b the logs and e = -ln U, the min likewise
+	//the max and the min take their own draws, so each has its exact law; drawing them independently given the end points
+	//approximates their joint law, so a double barrier that is narrow against the standard deviation of a step is priced
+	//a little high and wants a finer grid
+	//computed as sqrt(x0 x1) * exp(+-spread/2), one log and two exps per step
+	//a non positive price (e.g. Euler CEV) has no log bridge, the extremes are then the end points
+	static void BridgeExtremes(double x0, double x1, double variance, double eMax, double eMin, double& top, double& bottom)
+	{
+		bool positive = x0 > 0 && x1 > 0;
+		double d = std::log(positive ? x1 / x0 : 1.0);
+		double d2 = d * d;
+		double middle = std::sqrt(positive ? x0 * x1 : 1.0);
+		double upper = middle * std::exp(0.5 * std::sqrt(d2 + 2.0 * variance * eMax));
+		double lower = middle * std::exp(-0.5 * std::sqrt(d2 + 2.0 * variance * eMin));
+		top = positive ? upper : (x0 > x1 ? x0 : x1);
+		bottom = positive ? lower : (x0 < x1 ? x0 : x1);
+	}
+
+	//exponential draw from two normals, (z1^2 + z2^2) / 2 (a chi square with two degrees of freedom, halved)
+	static double Exponential(double z1, double z2)
+	{
+		return 0.5 * (z1 * z1 + z2 * z2);
+	}
+
+	//false once a product has to be folded into logSum
+	static bool InRange(double product)
+	{
+		return product < 1e250 && product > 1e-250;
+	}
+
+	//sum of the log prices, for geometric averages
+	double LogSum() const
+	{
+		return logSum + std::log(product);
+	}
+};
+
+// Derivatives of the running values of a path with respect to one parameter (S0 or the volatility)
+struct PathTangent
+{
+	double first = 0.0, last = 0.0, sum = 0.0, logSum = 0.0;	//logSum is the derivative of the sum of the log prices
+
+	void Start(double dS0, double S0)
+	{
+		first = last = sum = dS0;
+		logSum = dS0 / S0;
+	}
+
+	//derivative dS of the next price S
+	void Add(double dS, double S)
+	{
+		last = dS;
+		sum += dS;
+		logSum += dS / S;
+	}
+};
+
+// Sensitivities of one path for the Greeks
+struct PathGreeks
+{
+	PathTangent delta, vega;			//pathwise: d/dS0 and d/dvol of the running values
+	double deltaWeight = 0.0, vegaWeight = 0.0;		//likelihood ratio: d/dS0 and d/dvol of the log density of the path
+};
+
+// A control variate: a function of the (exact GBM) shadow path whose expectation is known in closed form
+struct ControlVariate
+{
+	std::function<double(const PathState&)> value;				//undiscounted control payoff of a shadow path
+	double mean;												//its exact expectation
+	bool terminalOnly = false;									//value reads only the shadow's last price
+};
+
+// Running mean, variances and covariance of pairs (y, c)
+// Within a batch of BatchSize pairs the sums are taken of the deviations from the batch's first pair, which keeps the
+// sums of squares small and free of cancellation at the cost of a few additions per pair. The batches are combined with
+// Chan's pairwise formula, so the error does not grow with the number of pairs
+class RunningMoments
+{
+private:
+	static const int BatchSize = 1024;
+
+	//combined batches
+	double m_n;					//number of pairs
+	double m_meanY, m_meanC;	//means
+	double m_m2Y, m_m2C, m_cYC;	//sums of the squared deviations from the means, and of their cross products
+
+	//open batch
+	int m_batch;				//pairs in the open batch
+	double m_shiftY, m_shiftC;	//its first pair
+	double m_sY, m_sC, m_sYY, m_sCC, m_sYC;	//sums of the deviations from the shift, their squares and products
+
+	//add the moments of n pairs
+	void Combine(double n, double meanY, double meanC, double m2Y, double m2C, double cYC)
+	{
+		if (n == 0.0)
+			return;
+		double total = m_n + n;
+		double dy = meanY - m_meanY;
+		double dc = meanC - m_meanC;
+		double weight = m_n * n / total;
+		m_meanY += dy * n / total;
+		m_meanC += dc * n / total;
+		m_m2Y += m2Y + dy * dy * weight;
+		m_m2C += m2C + dc * dc * weight;
+		m_cYC += cYC + dy * dc * weight;
+		m_n = total;
+	}
+
+	//move the open batch into the combined moments
+	void Flush()
+	{
+		double n = m_batch;
+		if (n > 0)
+		{
+			Combine(n, m_shiftY + m_sY / n, m_shiftC + m_sC / n,
+				m_sYY - m_sY * m_sY / n, m_sCC - m_sC * m_sC / n, m_sYC - m_sY * m_sC / n);
+		}
+		m_batch = 0;
+		m_sY = m_sC = m_sYY = m_sCC = m_sYC = 0.0;
+	}
+
+	//copy with the open batch flushed, for the getters
+	RunningMoments Total() const
+	{
+		RunningMoments total(*this);
+		total.Flush();
+		return total;
+	}
+public:
+	RunningMoments() : m_n(0.0), m_meanY(0.0), m_meanC(0.0), m_m2Y(0.0), m_m2C(0.0), m_cYC(0.0),
+		m_batch(0), m_shiftY(0.0), m_shiftC(0.0), m_sY(0.0), m_sC(0.0), m_sYY(0.0), m_sCC(0.0), m_sYC(0.0) {}
+
+	void Add(double y, double c)
+	{
+		if (m_batch == 0)
+		{
+			m_shiftY = y;
+			m_shiftC = c;
+		}
+		double dy = y - m_shiftY;
+		double dc = c - m_shiftC;
+		m_sY += dy;
+		m_sC += dc;
+		m_sYY += dy * dy;
+		m_sCC += dc * dc;
+		m_sYC += dy * dc;
+		if (++m_batch == BatchSize)
+			Flush();
+	}
+
+	//combine with the moments of another set of pairs
+	void Merge(const RunningMoments& other)
+	{
+		Flush();
+		RunningMoments total = other.Total();
+		Combine(total.m_n, total.m_meanY, total.m_meanC, total.m_m2Y, total.m_m2C, total.m_cYC);
+	}
+
+	//Getters
+	double Count() const { return m_n + m_batch; }
+	double MeanY() const { return Total().m_meanY; }
+	double MeanC() const { return Total().m_meanC; }
+
+	//population variances and covariance
+	double VarianceY() const { RunningMoments t = Total(); return t.m_n > 0.0 ? t.m_m2Y / t.m_n : 0.0; }
+	double VarianceC() const { RunningMoments t = Total(); return t.m_n > 0.0 ? t.m_m2C / t.m_n : 0.0; }
+	double Covariance() const { RunningMoments t = Total(); return t.m_n > 0.0 ? t.m_cYC / t.m_n : 0.0; }
+};
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 
 //Abstract Base(Interface) Pricer class
 class IPricer
@@ -31,17 +273,245 @@ protected:
 	PayoffFunction m_payoff;			//Payoff function
 	double m_discounter;				//discounting factor
 	double m_price;						//to store the final price
-	double m_squaredpayoff;				//used for standard deviation calculation
-	double m_sum;						//sum of all the simulations
-	int m_NSim;							//number of simulations
+	RunningMoments m_paths;				//payoff moments of every path (c unused)
+
+	//variance reduction
+	std::shared_ptr<ControlVariate> m_control;	//optional control variate
+	double m_samplePayoff, m_sampleControl;		//sums over the paths of the open sample
+	int m_samplePaths;
+	RunningMoments m_samples;					//payoff y and control c of the closed samples (paths, or antithetic pairs)
+
+	//adaptive runs
+	double m_target;							//target standard error, 0 = none
+	bool m_relativeTarget;						//target relative to the price
+
+	//Greeks
+	bool m_likelihoodRatio;						//likelihood ratio weights even though the payoff is smooth
+	double m_sampleDelta, m_sampleVega;			//sums over the paths of the open sample
+	bool m_sampleGreeks;						//the open sample came with PathGreeks
+	RunningMoments m_greeks;					//delta y and vega c (undiscounted) of the closed samples
+	double m_delta, m_gamma, m_vega;			//final Greeks
+
+	//label and value, N/A for a Greek that could not be estimated (NaN)
+	static void PrintGreek(const char* label, double value)
+	{
+		std::cout << label;
+		if (std::isnan(value))
+			std::cout << "N/A";
+		else
+			std::cout << value;
+	}
+
+	//price and standard errors from the accumulated moments
+	//rawSe treats every path as independent, reducedSe uses the samples and the control variate
+	void Statistics(double& price, double& rawSd, double& rawSe, double& reducedSe) const
+	{
+		double payoff = m_paths.MeanY();			//Averaged future value of the payoff
+		rawSd = std::sqrt(m_paths.VarianceY());		//standard deviation
+		rawSe = rawSd / std::sqrt(m_paths.Count());	//standard error
+
+		double varianceReduced = m_samples.VarianceY();
+		if (m_control && m_samples.Count() > 0)
+		{
+			//optimal coefficient beta = Cov(y,c)/Var(c), the residual variance is Var(y) - Cov(y,c)^2/Var(c)
+			double varC = m_samples.VarianceC();
+			double cov = m_samples.Covariance();
+			if (varC > 0)
+			{
+				double beta = cov / varC;
+				payoff = m_samples.MeanY() - beta * (m_samples.MeanC() - m_control->mean);
+				varianceReduced = std::max(m_samples.VarianceY() - cov*cov / varC, 0.0);
+			}
+		}
+
+		price = DiscountFactor() * payoff;	//present value(price)
+		rawSd *= DiscountFactor();
+		rawSe *= DiscountFactor();
+		reducedSe = DiscountFactor() * std::sqrt(varianceReduced / m_samples.Count());
+	}
+
+	//true if Payoff reads only the last price of the path
+	virtual bool TerminalPayoff() const
+	{
+		return false;
+	}
+
+	//true if Payoff is continuous in the path's running values, so its pathwise derivative is unbiased
+	virtual bool SmoothPayoff() const
+	{
+		return true;
+	}
+
+	//pathwise derivative: Payoff differentiated along the tangent by a central difference
+	double Directional(const PathState& path, const PathTangent& t)
+	{
+		double eps = 1e-6 * path.first / std::max(1.0, std::fabs(t.last));
+		PathState up = path, down = path;
+		up.first += eps * t.first;			down.first -= eps * t.first;
+		up.last += eps * t.last;			down.last -= eps * t.last;
+		up.sum += eps * t.sum;				down.sum -= eps * t.sum;
+		up.logSum += eps * t.logSum;		down.logSum -= eps * t.logSum;
+		return (Payoff(up) - Payoff(down)) / (2.0 * eps);
+	}
+
+	//copy the variance reduction and target settings to a clone
+	std::shared_ptr<IPricer> WithSettings(std::shared_ptr<IPricer> clone) const
+	{
+		clone->m_control = m_control;
+		clone->m_target = m_target;
+		clone->m_relativeTarget = m_relativeTarget;
+		clone->m_likelihoodRatio = m_likelihoodRatio;
+		return clone;
+	}
 public:
 	//Constructor
 	IPricer(PayoffFunction payoff, double discounter)
-		: m_payoff(payoff), m_discounter(discounter), m_price(0.0), m_squaredpayoff(0.0), m_sum(0.0), m_NSim(0) {}
+		: m_payoff(payoff), m_discounter(discounter), m_price(0.0),
+		m_samplePayoff(0.0), m_sampleControl(0.0), m_samplePaths(0), m_target(0.0), m_relativeTarget(false),
+		m_likelihoodRatio(false), m_sampleDelta(0.0), m_sampleVega(0.0), m_sampleGreeks(false),
+		m_delta(0.0), m_gamma(0.0), m_vega(0.0) {}
 
 	//Pure Virtual Functions
-	virtual void ProcessPath(const std::vector<double>& arr) = 0; // Process the payoff and increase NSim each time
-	virtual void PostProcess() = 0;								 // print final results
+	virtual double Payoff(const PathState& path) = 0;			 // undiscounted payoff of one path
+	virtual std::shared_ptr<IPricer> Clone() const = 0;			 // same option with empty accumulators, for a parallel worker
+	virtual std::string Name() const = 0;						 // e.g. "European Option", used in the printed results
+
+	//Use a control variate, the mediator must then pass the shadow paths (MCMediator::EnableControlVariate)
+	virtual void SetControlVariate(const ControlVariate& control) final
+	{
+		m_control = std::make_shared<ControlVariate>(control);
+	}
+	virtual bool HasControlVariate() const final
+	{
+		return bool(m_control);
+	}
+
+	//Target standard error of an adaptive run, absolute or relative to the price (0 = no target)
+	virtual void SetTargetError(double target, bool relative = false) final
+	{
+		m_target = target;
+		m_relativeTarget = relative;
+	}
+
+	//true if there is no target or the (variance reduced) standard error of the samples so far meets it
+	virtual bool TargetMet() const final
+	{
+		if (m_target <= 0)
+			return true;
+		if (m_samples.Count() < 2)
+			return false;
+		double price, sd, se, reducedSe;
+		Statistics(price, sd, se, reducedSe);
+		return reducedSe <= (m_relativeTarget ? m_target * std::fabs(price) : m_target);
+	}
+
+	//(standard error / target)^2, the factor by which the samples must grow to meet the target (0 = no target)
+	virtual double TargetRatio() const final
+	{
+		if (m_target <= 0 || m_samples.Count() < 2)
+			return 0.0;
+		double price, sd, se, reducedSe;
+		Statistics(price, sd, se, reducedSe);
+		double target = m_relativeTarget ? m_target * std::fabs(price) : m_target;
+		return target > 0 ? (reducedSe / target) * (reducedSe / target) : 0.0;
+	}
+
+	//Greeks from the likelihood ratio weights instead of the pathwise derivatives, for discontinuous payoffs
+	virtual void UseLikelihoodRatio(bool on) final
+	{
+		m_likelihoodRatio = on;
+	}
+	virtual bool LikelihoodRatio() const final
+	{
+		return m_likelihoodRatio || !SmoothPayoff();
+	}
+
+	//Payoff and control variate need only the terminal price, the mediator may then simulate one exact step per path
+	virtual bool TerminalOnly() const final
+	{
+		return TerminalPayoff() && (!m_control || m_control->terminalOnly);
+	}
+
+	//Add one path of the open sample, shadow is its exact GBM counterpart (may be null without a control variate)
+	//greeks are the path's sensitivities (null unless the Greeks are computed)
+	virtual void AddPath(const PathState& path, const PathState* shadow, const PathGreeks* greeks = nullptr) final
+	{
+		double current_payoff = Payoff(path);
+
+		if (greeks)
+		{
+			if (LikelihoodRatio())
+			{
+				m_sampleDelta += current_payoff * greeks->deltaWeight;
+				m_sampleVega += current_payoff * greeks->vegaWeight;
+			}
+			else
+			{
+				m_sampleDelta += Directional(path, greeks->delta);
+				m_sampleVega += Directional(path, greeks->vega);
+			}
+			m_sampleGreeks = true;
+		}
+
+		m_paths.Add(current_payoff, 0.0);		//accumulate the moments, used for the price and standard deviation
+
+		m_samplePayoff += current_payoff;
+		if (m_control && shadow)
+			m_sampleControl += m_control->value(*shadow);
+		m_samplePaths++;
+	}
+
+	//Close the open sample: its payoff and control are the averages over its paths (1, or 2 for an antithetic pair)
+	virtual void CloseSample() final
+	{
+		m_samples.Add(m_samplePayoff / m_samplePaths, m_sampleControl / m_samplePaths);
+		if (m_sampleGreeks)
+		{
+			m_greeks.Add(m_sampleDelta / m_samplePaths, m_sampleVega / m_samplePaths);
+			m_sampleDelta = 0.0;
+			m_sampleVega = 0.0;
+			m_sampleGreeks = false;
+		}
+
+		m_samplePayoff = 0.0;
+		m_sampleControl = 0.0;
+		m_samplePaths = 0;
+	}
+
+	// Process the payoff of a single independent path and increase NSim
+	virtual void ProcessPath(const PathState& path) final
+	{
+		AddPath(path, nullptr);
+		CloseSample();
+	}
+
+	// print final results
+	virtual void PostProcess()
+	{//Calculating the final price
+		double sd, se, reducedSe;
+		Statistics(m_price, sd, se, reducedSe);
+
+		//print the result
+		std::cout << std::showpoint << std::setprecision(6) << std::fixed		//format the output
+			<< Name() << " Post Process - Final Price = " << m_price
+			<< ", Standard Deviation = " << sd << ", Standard Error = " << se;
+		bool antithetic = m_samples.Count() != m_paths.Count();
+		if (m_control || antithetic)
+		{
+			std::cout << ", Variance Reduced Standard Error = " << reducedSe
+				<< " (" << (antithetic ? "antithetic" : "") << (m_control && antithetic ? " + " : "")
+				<< (m_control ? "control variate" : "") << ")";
+		}
+		std::cout << std::endl;
+	}
+
+	//Add the paths accumulated by another pricer (e.g. a worker's clone) to this one
+	virtual void Merge(const IPricer& other) final
+	{
+		m_paths.Merge(other.m_paths);
+		m_samples.Merge(other.m_samples);
+		m_greeks.Merge(other.m_greeks);
+	}
 
 																 //Getters (Template Method Pattern)
 	virtual double DiscountFactor() const final
@@ -52,6 +522,88 @@ public:
 	{// return the option price
 		return m_price;
 	}
+	virtual long long Paths() const final
+	{// number of paths processed so far
+		return (long long)(m_paths.Count());
+	}
+	virtual double Estimate(bool corrected = true) const final
+	{// price from the paths processed so far, control variate corrected if there is one (and corrected is true)
+		if (!corrected)
+			return DiscountFactor() * m_paths.MeanY();
+		double price, sd, se, reducedSe;
+		Statistics(price, sd, se, reducedSe);
+		return price;
+	}
+	virtual double Delta() const final
+	{// Greeks of the last startGreeks run, NaN when there were too few samples to estimate them
+		return m_delta;
+	}
+	virtual double Gamma() const final
+	{
+		return m_gamma;
+	}
+	virtual double Vega() const final
+	{
+		return m_vega;
+	}
+
+	//delta and vega accumulated from the PathGreeks so far, with their standard errors, false if there were none
+	virtual bool GreekEstimates(double& delta, double& deltaSe, double& vega, double& vegaSe) const final
+	{
+		double n = m_greeks.Count();
+		if (n < 2)
+			return false;
+		delta = DiscountFactor() * m_greeks.MeanY();
+		vega = DiscountFactor() * m_greeks.MeanC();
+		deltaSe = DiscountFactor() * std::sqrt(m_greeks.VarianceY() / n);
+		vegaSe = DiscountFactor() * std::sqrt(m_greeks.VarianceC() / n);
+		return true;
+	}
+
+	//Multilevel Monte Carlo result (MLMCDriver): the price is the sum of the level estimates, se their combined error
+	virtual void PostProcessMultilevel(double price, double se, int levels) final
+	{
+		m_price = price;
+		std::cout << std::showpoint << std::setprecision(6) << std::fixed		//format the output
+			<< Name() << " MLMC Post Process - Final Price = " << m_price
+			<< ", Levels = " << levels << ", MLMC Standard Error = " << se << std::endl;
+	}
+
+	//store and print the final Greeks, method tells how they were computed
+	virtual void PostProcessGreeks(double delta, double gamma, double vega, const std::string& method) final
+	{
+		m_delta = delta;
+		m_gamma = gamma;
+		m_vega = vega;
+
+		std::cout << std::showpoint << std::setprecision(6) << std::fixed		//format the output
+			<< Name() << " Greeks (" << method << ")";
+		PrintGreek(" - Delta = ", m_delta);
+		PrintGreek(", Gamma = ", m_gamma);
+		PrintGreek(", Vega = ", m_vega);
+		double d, dSe, v, vSe;
+		if (GreekEstimates(d, dSe, v, vSe))
+			std::cout << ", Delta Standard Error = " << dSe << ", Vega Standard Error = " << vSe;
+		std::cout << std::endl;
+	}
+
+	//Randomized QMC result: the price is the mean of independent replication estimates, the error is their standard error
+	virtual void PostProcessReplications(const std::vector<double>& estimates) final
+	{
+		RunningMoments moments;
+		for (auto it = estimates.begin(); it != estimates.end(); ++it)
+		{
+			moments.Add(*it, 0.0);
+		}
+		double R = moments.Count();
+		double variance = moments.VarianceY() * R / (R - 1.0);		//sample variance across the replications
+		double se = std::sqrt(variance / R);
+
+		m_price = moments.MeanY();
+		std::cout << std::showpoint << std::setprecision(6) << std::fixed		//format the output
+			<< Name() << " RQMC Post Process - Final Price = " << m_price
+			<< ", Replications = " << estimates.size() << ", RQMC Standard Error = " << se << std::endl;
+	}
 };
 
 
@@ -66,33 +618,25 @@ public:
 	//Constrcuctor
 	EuropeanPricer(PayoffFunction payoff, double discounter) : IPricer(payoff, discounter) {}
 
-	//Derived Functions
-	virtual void ProcessPath(const std::vector<double>& arr) override
-	{// Process the payoff and increase NSim each time
-
-		double current_payoff = m_payoff(arr.back());			//call payoff function to get current payoff base on the ending price
-
-		m_squaredpayoff += (current_payoff * current_payoff);	//squared sum, used for standard deviation calculation
-
-		m_sum += current_payoff;	// accumulate the sum
-
-		m_NSim++;		//increase the number of simulations after each call
+	virtual std::shared_ptr<IPricer> Clone() const override
+	{
+		return WithSettings(std::make_shared<EuropeanPricer>(m_payoff, m_discounter));
 	}
 
-	virtual void PostProcess() override
-	{//Calculating the final price
-
-		double payoff = m_sum / (m_NSim*1.0);	//Averaged future value of the payoff
-		m_price = DiscountFactor() * payoff;	//present value(price)
+	virtual std::string Name() const override
+	{
+		return "European Option";
+	}
 
-												//Note: VAR(x) = sum(xi*xi)/N - (avg)^2.
-		double sd = std::sqrt((m_squaredpayoff / (m_NSim*1.0)) - payoff*payoff);	//standard deviation
-		double se = sd / std::sqrt(m_NSim);		//standard error
+	virtual bool TerminalPayoff() const override
+	{
+		return true;
+	}
 
-												//print the result
-		std::cout << std::showpoint << std::setprecision(6) << std::fixed		//format the output
-			<< "European Option Post Process - Final Price = " << m_price
-			<< ", Standard Deviation = " << sd << ", Standard Error = " << se << std::endl;
+	//Derived Functions
+	virtual double Payoff(const PathState& path) override
+	{
+		return m_payoff(path.last);			//call payoff function to get current payoff base on the ending price
 	}
 };
 
@@ -101,48 +645,32 @@ public:
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 //Asian pricer's average function
-using AverageFunction = std::function<double(const std::vector<double>&)>;
+using AverageFunction = std::function<double(const PathState&)>;
 
 //Concrete Derived Pricer class : Asian Option Pricer
 //Base on the average(arithmetic or geometric) price instead of the ending price
 class AsianPricer : public IPricer
 {
 private:
-	double m_average;				//average price
 	AverageFunction m_avgfunc;		//Assign Asian Pricer's average function(Geometric or Arithmetic)
 public:
 	//Constructor
 	AsianPricer(PayoffFunction payoff, double discounter, AverageFunction avgfunc)
-		: IPricer(payoff, discounter), m_avgfunc(avgfunc), m_average(0.0) {}
+		: IPricer(payoff, discounter), m_avgfunc(avgfunc) {}
 
-	virtual void ProcessPath(const std::vector<double>& arr) override
-	{// Process the payoff and increase NSim each time
-
-		m_average = m_avgfunc(arr);		//call payoff function to get the average price over the period
-
-		double current_payoff = m_payoff(m_average);		//call payoff function to get current payoff base on the average price
-
-		m_squaredpayoff += (current_payoff * current_payoff);	//squared sum, used for standard deviation calculation
-
-		m_sum += current_payoff;	//accumulate the sum
-
-		m_NSim++;			//increase the number of simulations after each call
+	virtual std::shared_ptr<IPricer> Clone() const override
+	{
+		return WithSettings(std::make_shared<AsianPricer>(m_payoff, m_discounter, m_avgfunc));
 	}
 
-	virtual void PostProcess() override
-	{//Calculating the final price
-
-		double payoff = m_sum / (m_NSim*1.0);	//average future value of the payoff
-		m_price = DiscountFactor() * payoff;	//present value(price)
-
-												//Note: VAR(x) = sum(xi*xi)/N - (avg)^2.
-		double sd = std::sqrt((m_squaredpayoff / (m_NSim*1.0)) - payoff*payoff);	//standard deviation
-		double se = sd / std::sqrt(m_NSim);			//standard error
+	virtual std::string Name() const override
+	{
+		return "Asian Option";
+	}
 
-													//print the result
-		std::cout << std::showpoint << std::setprecision(6) << std::fixed		//format the output
-			<< "Asian Option Post Process - Final Price = " << m_price
-			<< ", Standard Deviation = " << sd << ", Standard Error = " << se << std::endl;
+	virtual double Payoff(const PathState& path) override
+	{
+		return m_payoff(m_avgfunc(path));		//call payoff function base on the average price over the period
 	}
 };
 
@@ -150,10 +678,12 @@ public:
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-//return bool from a vector to show whether knock in or knock out
-using KnockFunction = std::function<bool(const std::vector<double>&)>;
+//return bool from the path's running max and min to show whether knock in or knock out
+using KnockFunction = std::function<bool(const PathState&)>;
 
 //Concrete Derived Pricer class : Barrier Option Pricer
+//The knock function reads the path's max and min, at the grid points or, with MCMediator::EnableContinuousMonitoring,
+//including the Brownian bridge between them
 class BarrierPricer : public IPricer
 {
 private:
@@ -163,33 +693,28 @@ public:
 	BarrierPricer(PayoffFunction payoff, double discounter, KnockFunction knock)
 		: IPricer(payoff, discounter), m_knock(knock) {}
 
-	virtual void ProcessPath(const std::vector<double>& arr) override
+	virtual std::shared_ptr<IPricer> Clone() const override
 	{
-		//if not knocked out(if return false), there will be payoff
-		if (!m_knock(arr))
-		{
-			double current_payoff = m_payoff(arr.back());			//call payoff function base on the ending price
-			m_squaredpayoff += (current_payoff * current_payoff);	//used for standard deviation calculation
-			m_sum += current_payoff;								//accumulate the sum
-		}
-
-		m_NSim++;		//increase the number of simulations after each call
+		return WithSettings(std::make_shared<BarrierPricer>(m_payoff, m_discounter, m_knock));
 	}
 
-	virtual void PostProcess() override
-	{//Calculating the final price
-
-		double payoff = m_sum / (m_NSim*1.0);	//average future value of the payoff
-		m_price = DiscountFactor() * payoff;	//present value(price)
+	virtual std::string Name() const override
+	{
+		return "Barrier Option";
+	}
 
-												//Note: VAR(x) = sum(xi*xi)/N - (avg)^2.
-		double sd = std::sqrt((m_squaredpayoff / (m_NSim*1.0)) - payoff*payoff);	//standard deviation
-		double se = sd / std::sqrt(m_NSim);			//standard error
+	//the knock indicator jumps, so the Greeks use the likelihood ratio weights
+	virtual bool SmoothPayoff() const override
+	{
+		return false;
+	}
 
-													//print the result
-		std::cout << std::showpoint << std::setprecision(6) << std::fixed		//format the output
-			<< "Barrier Option Post Process - Final Price = " << m_price
-			<< ", Standard Deviation = " << sd << ", Standard Error = " << se << std::endl;
+	virtual double Payoff(const PathState& path) override
+	{
+		//if not knocked out(if return false), there will be payoff
+		if (!m_knock(path))
+			return m_payoff(path.last);			//call payoff function base on the ending price
+		return 0.0;
 	}
 };
 
@@ -5,7 +5,14 @@
 // Use STL distribution and random devices to generate random numbers with a Standard Normal Distribution(0,1)
 //
 // One Base class : IRNG
-// Three Derived classes : Mersenne Twister on Normal Distribution, BoxMuller, and PolarMarsaglia
+// Five Derived classes : Mersenne Twister on Normal Distribution, BoxMuller, PolarMarsaglia, Philox and Ziggurat
+//
+// Stream(seed, stream) returns a fresh generator of the same kind for a parallel worker, seeded from (seed, stream)
+// through std::seed_seq, so every worker has its own reproducible sequence
+//
+// Fill(out, n) writes n normals at once. The generators override it with loops that skip the per draw function
+// wrapper and, for Box Muller, Polar Marsaglia and Philox, vectorize the transform (#pragma omp simd) and use both
+// variates of every pair. Fill continues the generator's state, so the two calls can be mixed freely
 //
 //
 //
@@ -17,6 +24,11 @@
 #include<boost\math\constants\constants.hpp>		//for pi
 #include<iostream>
 #include<functional>
+#include<memory>
+#include<cstdint>
+#include<vector>
+#include<cstddef>
+#include<algorithm>
 
 //universal function wrapper for generating random numbers
 using RNGFunction = std::function<double()>;
@@ -36,9 +48,26 @@ public:
 	{
 		return rng();
 	}
+
+	//write n normals to out, the default just calls GenerateRng n times
+	virtual void Fill(double* out, std::size_t n)
+	{
+		for (std::size_t i = 0; i < n; i++)
+			out[i] = rng();
+	}
+
+	//the first n normals of every Fill are the increments of one path, the rest are auxiliary draws (e.g. the Brownian
+	//bridge extremes); only a quasi random generator treats them differently
+	virtual void PathLength(std::size_t n)
+	{
+	}
+
+	//Pure Virtual Function
+	//new generator of the same kind seeded from (seed, stream), used by one parallel worker
+	virtual std::shared_ptr<IRNG> Stream(unsigned long seed, unsigned long stream) const = 0;
 };
 
-class MTNormalRNG : public IRNG
+class MTNormalRNG final : public IRNG
 {
 private:
 	std::mt19937 mt;
@@ -50,20 +79,37 @@ public:
 		normal = std::normal_distribution<double>(v1, v2);
 		rng = [&]() { return normal(mt); }; // specify the function implementation
 	}
+
+	virtual void Fill(double* out, std::size_t n) override
+	{
+		for (std::size_t i = 0; i < n; i++)
+			out[i] = normal(mt);
+	}
+
+	virtual std::shared_ptr<IRNG> Stream(unsigned long seed, unsigned long stream) const override
+	{
+		auto result = std::make_shared<MTNormalRNG>(normal.mean(), normal.stddev());
+		std::seed_seq seq{ seed, stream };
+		result->mt.seed(seq);
+		return result;
+	}
 };
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 
 //Concrete Derived RNG class : Box Muller Method
-class BoxMullerRNG : public IRNG
+class BoxMullerRNG final : public IRNG
 {
 private:
 	std::default_random_engine eng;	//random engine
 	std::uniform_real_distribution<double> uniform;	//uniform distribution(0,1)
+	double m_spare;					//sine variate of the last pair, returned by the next draw
+	bool m_hasSpare;
+	std::vector<double> m_uniforms;	//uniforms buffer for Fill
 public:
 	//Constructor
-	BoxMullerRNG() : IRNG()
+	BoxMullerRNG() : IRNG(), m_spare(0.0), m_hasSpare(false)
 	{
 		eng = std::default_random_engine();
 		uniform = std::uniform_real_distribution<double>(0.0, 1.0);	//uniform distribution(0,1)
@@ -71,14 +117,59 @@ public:
 																	// r and phi are independent uniform random numbers in (0,1)
 		rng = [&]()
 		{
+			if (m_hasSpare)
+			{
+				m_hasSpare = false;
+				return m_spare;
+			}
+
 			double r = uniform(eng);
 			double phi = uniform(eng);
 
-			//This will return a number with the standard normal distribution
-			return std::sqrt(-2.0*std::log(r))*std::cos(2.0 * boost::math::constants::pi<double>()*phi);
+			//Both numbers below have the standard normal distribution and are independent
+			double radius = std::sqrt(-2.0*std::log(r));
+			m_spare = radius*std::sin(2.0 * boost::math::constants::pi<double>()*phi);
+			m_hasSpare = true;
+			return radius*std::cos(2.0 * boost::math::constants::pi<double>()*phi);
 		};
 	}
 
+	virtual void Fill(double* out, std::size_t n) override
+	{
+		std::size_t i = 0;
+		if (n > 0 && m_hasSpare)
+			out[i++] = rng();
+
+		//draw the uniforms first so the transform below is a branch free loop
+		std::size_t pairs = (n - i) / 2;
+		m_uniforms.resize(2 * pairs);
+		for (std::size_t k = 0; k < 2 * pairs; k++)
+			m_uniforms[k] = uniform(eng);
+
+		const double* u = m_uniforms.data();
+		double* pairOut = out + i;
+		const double twoPi = 2.0 * boost::math::constants::pi<double>();
+#pragma omp simd
+		for (std::size_t k = 0; k < pairs; k++)
+		{
+			double radius = std::sqrt(-2.0*std::log(u[2 * k]));
+			pairOut[2 * k] = radius*std::cos(twoPi*u[2 * k + 1]);
+			pairOut[2 * k + 1] = radius*std::sin(twoPi*u[2 * k + 1]);
+		}
+
+		//odd count, the last draw leaves its sine variate for the next call
+		if (i + 2 * pairs < n)
+			out[n - 1] = rng();
+	}
+
+	virtual std::shared_ptr<IRNG> Stream(unsigned long seed, unsigned long stream) const override
+	{
+		auto result = std::make_shared<BoxMullerRNG>();
+		std::seed_seq seq{ seed, stream };
+		result->eng.seed(seq);
+		return result;
+	}
+
 };
 
 
@@ -87,20 +178,31 @@ public:
 
 
 //Concrete Derived RNG class : Polar Marsaglia Method
-class PolarMarsagliaRNG : public IRNG
+class PolarMarsagliaRNG final : public IRNG
 {
 private:
 	std::default_random_engine eng;					//random engine
 	std::uniform_real_distribution<double> uniform;	//uniform distribution(0,1)
+	double m_spare;					//V2 * Y of the last accepted pair, returned by the next draw
+	bool m_hasSpare;
+	std::vector<double> m_candidates;	//V1, V2 pairs for Fill
+	std::vector<double> m_factors;		//Y of each candidate pair, 0 if rejected
+	std::vector<double> m_accepted;		//normals of the accepted pairs, in order
 public:
 	//Constructor
-	PolarMarsagliaRNG() : IRNG()
+	PolarMarsagliaRNG() : IRNG(), m_spare(0.0), m_hasSpare(false)
 	{
 		eng = std::default_random_engine();
 		uniform = std::uniform_real_distribution<double>(0.0, 1.0);
 
 		rng = [&]()
 		{
+			if (m_hasSpare)
+			{
+				m_hasSpare = false;
+				return m_spare;
+			}
+
 			double V1, V2, W;												//Loop until W is in between of 0 and 1
 			do
 			{
@@ -108,14 +210,355 @@ public:
 				V2 = 2.0 * uniform(eng) - 1.0;	//V2 is(-1,1)
 				W = V1 * V1 + V2 * V2;	//W = V1^2 + V2^2
 
-			} while (W > 1.0);	//Stop when W is smaller than 1
+			} while (W > 1.0 || W == 0.0);	//Stop when W is smaller than 1
 
 			double Y = std::sqrt(-2.0 *std::log(W) / W);
 
-			//This will return a number with the standard normal distribution
+			//Both numbers below have the standard normal distribution and are independent
+			m_spare = V2 * Y;
+			m_hasSpare = true;
 			return V1 * Y;
 		};
 	}
+
+	virtual void Fill(double* out, std::size_t n) override
+	{
+		std::size_t i = 0;
+		if (n > 0 && m_hasSpare)
+			out[i++] = rng();
+
+		while (i < n)
+		{
+			//about pi/4 of the candidate pairs are accepted, draw a few more than needed
+			std::size_t pairs = (n - i) * 2 / 3 + 8;
+			m_candidates.resize(2 * pairs);
+			m_factors.resize(pairs);
+			for (std::size_t k = 0; k < 2 * pairs; k++)
+				m_candidates[k] = 2.0 * uniform(eng) - 1.0;
+
+			//the log and sqrt of every candidate in one vectorized pass, rejected pairs get Y = 0
+			const double* v = m_candidates.data();
+			double* y = m_factors.data();
+#pragma omp simd
+			for (std::size_t k = 0; k < pairs; k++)
+			{
+				double W = v[2 * k] * v[2 * k] + v[2 * k + 1] * v[2 * k + 1];
+				bool accepted = W < 1.0 && W > 0.0;
+				double safeW = accepted ? W : 0.5;
+				y[k] = accepted ? std::sqrt(-2.0 * std::log(safeW) / safeW) : 0.0;
+			}
+
+			//branch free compaction, every pair is written and the slot only advances if it was accepted
+			m_accepted.resize(2 * pairs);
+			double* accepted = m_accepted.data();
+			std::size_t count = 0;
+			for (std::size_t k = 0; k < pairs; k++)
+			{
+				accepted[count] = v[2 * k] * y[k];
+				accepted[count + 1] = v[2 * k + 1] * y[k];
+				count += (y[k] != 0.0) ? 2 : 0;
+			}
+
+			//the unused tail is dropped, except the second half of a pair that was split at the end
+			std::size_t take = std::min(count, n - i);
+			std::copy(accepted, accepted + take, out + i);
+			i += take;
+			if (take % 2 == 1)
+			{
+				m_spare = accepted[take];
+				m_hasSpare = true;
+			}
+		}
+	}
+
+	virtual std::shared_ptr<IRNG> Stream(unsigned long seed, unsigned long stream) const override
+	{
+		auto result = std::make_shared<PolarMarsagliaRNG>();
+		std::seed_seq seq{ seed, stream };
+		result->eng.seed(seq);
+		return result;
+	}
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+//Concrete Derived RNG class : Philox4x32-10 counter based generator (Salmon et al., Random123)
+//Every block of normals is a pure function of (seed, stream, counter), so streams never overlap and
+//any draw can be reached in O(1) with Seek, e.g. path p of an NT step simulation starts at draw p * NT
+class PhiloxRNG final : public IRNG
+{
+private:
+	std::uint32_t m_key[2];			//seed
+	std::uint64_t m_stream;			//upper half of the counter
+	std::uint64_t m_counter;		//lower half of the counter, one block per two normals
+	double m_normals[2];			//both Box Muller outputs of the current block
+	int m_next;						//index of the next unused normal in m_normals, 2 = block used up
+	std::vector<double> m_uniforms;	//uniforms buffer for Fill
+
+	//10 rounds of Philox4x32 on the counter (counter, stream) under the key (k0, k1)
+	static void Rounds(std::uint64_t counter, std::uint64_t stream, std::uint32_t k0, std::uint32_t k1,
+		std::uint32_t& out0, std::uint32_t& out1, std::uint32_t& out2, std::uint32_t& out3)
+	{
+		const std::uint32_t M0 = 0xD2511F53, M1 = 0xCD9E8D57;
+		const std::uint32_t W0 = 0x9E3779B9, W1 = 0xBB67AE85;
+
+		std::uint32_t c0 = std::uint32_t(counter), c1 = std::uint32_t(counter >> 32);
+		std::uint32_t c2 = std::uint32_t(stream), c3 = std::uint32_t(stream >> 32);
+
+		for (int round = 0; round < 10; round++)
+		{
+			std::uint64_t p0 = std::uint64_t(M0) * c0;
+			std::uint64_t p1 = std::uint64_t(M1) * c2;
+			std::uint32_t n0 = std::uint32_t(p1 >> 32) ^ c1 ^ k0;
+			std::uint32_t n2 = std::uint32_t(p0 >> 32) ^ c3 ^ k1;
+			c0 = n0;
+			c1 = std::uint32_t(p1);
+			c2 = n2;
+			c3 = std::uint32_t(p0);
+			k0 += W0;
+			k1 += W1;
+		}
+
+		out0 = c0; out1 = c1; out2 = c2; out3 = c3;
+	}
+
+	void Block(std::uint32_t out[4]) const
+	{
+		Rounds(m_counter, m_stream, m_key[0], m_key[1], out[0], out[1], out[2], out[3]);
+	}
+
+	//53 bit uniform in (0,1) from two 32 bit words
+	static double Uniform(std::uint32_t a, std::uint32_t b)
+	{
+		//the shifted words fit in a signed int, which converts to double in a vector register
+		return (std::int32_t(a >> 5) * 67108864.0 + std::int32_t(b >> 6) + 0.5) / 9007199254740992.0;
+	}
+
+	//turn the current counter into two normals and move to the next block
+	void Refill()
+	{
+		std::uint32_t bits[4];
+		Block(bits);
+		m_counter++;
+
+		double r = std::sqrt(-2.0 * std::log(Uniform(bits[0], bits[1])));
+		double phi = 2.0 * boost::math::constants::pi<double>() * Uniform(bits[2], bits[3]);
+		m_normals[0] = r * std::cos(phi);
+		m_normals[1] = r * std::sin(phi);
+		m_next = 0;
+	}
+public:
+	//Constructor
+	PhiloxRNG(unsigned long seed = 0, unsigned long stream = 0) : IRNG()
+	{
+		std::uint64_t key = seed;
+		m_key[0] = std::uint32_t(key);
+		m_key[1] = std::uint32_t(key >> 32);
+		m_stream = stream;
+		m_counter = 0;
+		m_next = 2;
+
+		rng = [&]()
+		{
+			if (m_next == 2)
+				Refill();
+			return m_normals[m_next++];
+		};
+	}
+
+	//raw Philox4x32-10 output for a counter and key, e.g. for checking against the Random123 known answers
+	static void Block(const std::uint32_t counter[4], const std::uint32_t key[2], std::uint32_t out[4])
+	{
+		Rounds(counter[0] | (std::uint64_t(counter[1]) << 32), counter[2] | (std::uint64_t(counter[3]) << 32), key[0], key[1], out[0], out[1], out[2], out[3]);
+	}
+
+	//one counter block per pair, the blocks are independent so both loops vectorize
+	virtual void Fill(double* out, std::size_t n) override
+	{
+		std::size_t i = 0;
+		while (i < n && m_next < 2)
+			out[i++] = m_normals[m_next++];
+
+		std::size_t pairs = (n - i) / 2;
+		m_uniforms.resize(2 * pairs);
+		double* u = m_uniforms.data();
+		const std::uint64_t counter = m_counter, stream = m_stream;
+		const std::uint32_t k0 = m_key[0], k1 = m_key[1];
+
+		//integer rounds and the transform are separate loops, each runs at its own vector width
+#pragma omp simd
+		for (std::size_t k = 0; k < pairs; k++)
+		{
+			std::uint32_t b0, b1, b2, b3;
+			Rounds(counter + k, stream, k0, k1, b0, b1, b2, b3);
+			u[2 * k] = Uniform(b0, b1);
+			u[2 * k + 1] = Uniform(b2, b3);
+		}
+		m_counter += pairs;
+
+		double* pairOut = out + i;
+		const double twoPi = 2.0 * boost::math::constants::pi<double>();
+#pragma omp simd
+		for (std::size_t k = 0; k < pairs; k++)
+		{
+			double r = std::sqrt(-2.0 * std::log(u[2 * k]));
+			pairOut[2 * k] = r * std::cos(twoPi * u[2 * k + 1]);
+			pairOut[2 * k + 1] = r * std::sin(twoPi * u[2 * k + 1]);
+		}
+
+		if (i + 2 * pairs < n)
+			out[n - 1] = rng();
+	}
+
+	//jump to the given normal draw of this stream
+	void Seek(std::uint64_t draw)
+	{
+		m_counter = draw / 2;
+		m_next = 2;
+		if (draw % 2 == 1)
+		{
+			Refill();
+			m_next = 1;
+		}
+	}
+
+	//index of the next normal draw of this stream
+	std::uint64_t Position() const
+	{
+		return 2 * m_counter - (2 - m_next);
+	}
+
+	virtual std::shared_ptr<IRNG> Stream(unsigned long seed, unsigned long stream) const override
+	{
+		return std::make_shared<PhiloxRNG>(seed, stream);
+	}
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+//Concrete Derived RNG class : Ziggurat Method (Marsaglia and Tsang 2000, 128 layers as in Doornik's ZIGNOR)
+//About 99% of the draws are one table lookup and one multiply, no log, sqrt or trigonometry.
+//Every 64 bit word of the engine gives the layer (low 7 bits) and an independent uniform (top 53 bits)
+class ZigguratRNG final : public IRNG
+{
+private:
+	static const int Layers = 128;
+	static constexpr double TailStart = 3.442619855899;			//R, where the base layer's tail begins
+	static constexpr double LayerArea = 9.91256303526217e-3;	//V, area of every layer
+
+	std::mt19937_64 eng;				//random engine
+	double m_x[Layers + 1];				//right edge of each layer
+	double m_ratio[Layers];				//m_x[i+1] / m_x[i], below it a point is inside the curve for sure
+	std::vector<std::uint64_t> m_words;	//engine output buffer for Fill
+
+	//uniform in (0,1)
+	double Uniform()
+	{
+		return ((eng() >> 11) + 0.5) / 9007199254740992.0;
+	}
+
+	//uniform in [-1,1) from the top 53 bits of a word
+	static double Signed(std::uint64_t word)
+	{
+		return std::int64_t(word >> 11) / 4503599627370496.0 - 1.0;
+	}
+
+	//draws outside the inner rectangle of their layer: the wedge test, the tail, or a fresh start
+	double Slow(int layer, double u)
+	{
+		for (;;)
+		{
+			if (layer == 0)
+			{//Marsaglia's tail algorithm beyond R
+				double x, y;
+				do
+				{
+					x = std::log(Uniform()) / TailStart;
+					y = std::log(Uniform());
+				} while (-2.0 * y < x * x);
+				return u < 0 ? x - TailStart : TailStart - x;
+			}
+
+			double x = u * m_x[layer];
+			double f0 = std::exp(-0.5 * (m_x[layer] * m_x[layer] - x * x));
+			double f1 = std::exp(-0.5 * (m_x[layer + 1] * m_x[layer + 1] - x * x));
+			if (f1 + Uniform() * (f0 - f1) < 1.0)
+				return x;
+
+			//rejected, draw a new layer and point
+			std::uint64_t word = eng();
+			layer = int(word & (Layers - 1));
+			u = Signed(word);
+			if (std::abs(u) < m_ratio[layer])
+				return u * m_x[layer];
+		}
+	}
+public:
+	//Constructor
+	ZigguratRNG(unsigned long seed = 0) : IRNG(), eng(seed)
+	{
+		//layer edges from the equal area condition x[i] * (f(x[i+1]) - f(x[i])) = V
+		double f = std::exp(-0.5 * TailStart * TailStart);
+		m_x[0] = LayerArea / f;
+		m_x[1] = TailStart;
+		m_x[Layers] = 0;
+		for (int i = 2; i < Layers; i++)
+		{
+			m_x[i] = std::sqrt(-2.0 * std::log(LayerArea / m_x[i - 1] + f));
+			f = std::exp(-0.5 * m_x[i] * m_x[i]);
+		}
+		for (int i = 0; i < Layers; i++)
+			m_ratio[i] = m_x[i + 1] / m_x[i];
+
+		rng = [&]()
+		{
+			std::uint64_t word = eng();
+			int layer = int(word & (Layers - 1));
+			double u = Signed(word);
+			if (std::abs(u) < m_ratio[layer])
+				return u * m_x[layer];
+			return Slow(layer, u);
+		};
+	}
+
+	//the rectangle test runs for the whole buffer in one vectorized pass, the rare misses are redone one by one
+	virtual void Fill(double* out, std::size_t n) override
+	{
+		m_words.resize(n);
+		for (std::size_t i = 0; i < n; i++)
+			m_words[i] = eng();
+
+		const std::uint64_t* words = m_words.data();
+		const double* x = m_x;
+		const double* ratio = m_ratio;
+#pragma omp simd
+		for (std::size_t i = 0; i < n; i++)
+		{
+			int layer = int(words[i] & (Layers - 1));
+			double u = Signed(words[i]);
+			out[i] = std::abs(u) < ratio[layer] ? u * x[layer] : 0.0;
+		}
+
+		//misses were marked with 0. A genuine 0 only comes from u = 0, which Slow maps to 0 except in layer 0 where it
+		//samples the tail instead, a draw with probability about 2^-60
+		for (std::size_t i = 0; i < n; i++)
+		{
+			if (out[i] == 0.0)
+				out[i] = Slow(int(words[i] & (Layers - 1)), Signed(words[i]));
+		}
+	}
+
+	virtual std::shared_ptr<IRNG> Stream(unsigned long seed, unsigned long stream) const override
+	{
+		auto result = std::make_shared<ZigguratRNG>();
+		std::seed_seq seq{ seed, stream };
+		result->eng.seed(seq);
+		return result;
+	}
 };
 
 #endif
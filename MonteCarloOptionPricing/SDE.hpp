@@ -8,6 +8,9 @@
 // One Base class: ISDE
 // Two SDE Models as the Derived classes: GBM(Geometric Brownian Motion) and CEV(Constant Elasticity of Variance)
 //
+// The derivatives of the drift and diffusion (and the volatility they scale with) are used by the FDM classes to
+// differentiate their steps for the Monte Carlo Greeks
+//
 //
 //
 
@@ -37,6 +40,14 @@ public:
 	virtual double DriftCorrected(double x, double B) = 0;
 	virtual double DiffusionDerivative(double x) = 0;
 
+	//Derivatives for the Greeks
+	virtual double DriftDerivative(double x) = 0;				// d Drift / dx
+	virtual double DiffusionSecondDerivative(double x) = 0;	// d2 Diffusion / dx2
+
+	//The volatility input, the diffusion of both models is proportional to it (d Diffusion / d vol = Diffusion / vol)
+	virtual double Volatility() const = 0;
+	virtual void Volatility(double vol) = 0;
+
 	//Getters and Setters(Template Method Pattern)
 	virtual void InitialCondition(double val) final
 	{//set InitialCondition
@@ -63,7 +74,7 @@ public:
 
 //Concrete Derived SDE class : Geometric Brownian Motion (GBM) 
 //Typical GBM Function : dS = mu(t)Sdt + sig(t)SdW
-class GBM : public ISDE
+class GBM final : public ISDE
 {
 private:
 	double m_mu;				// Drift
@@ -74,6 +85,20 @@ public:
 	GBM(double driftCoeff, double diffusionCoeff, double dividend, double initialCondition, double expiry)
 		: ISDE(initialCondition, expiry), m_mu(driftCoeff), m_vol(diffusionCoeff), m_div(dividend) {}
 
+	//Getters of the coefficients
+	virtual double DriftCoefficient() const final
+	{
+		return m_mu;
+	}
+	virtual double DiffusionCoefficient() const final
+	{
+		return m_vol;
+	}
+	virtual double Dividend() const final
+	{
+		return m_div;
+	}
+
 	//Derived Functions below
 
 	//Drift and Diffusion
@@ -96,6 +121,25 @@ public:
 	{
 		return m_vol;
 	}
+
+	//Derivatives for the Greeks
+	virtual double DriftDerivative(double x) override
+	{
+		return m_mu - m_div;
+	}
+	virtual double DiffusionSecondDerivative(double x) override
+	{
+		return 0.0;
+	}
+
+	virtual double Volatility() const override
+	{
+		return m_vol;
+	}
+	virtual void Volatility(double vol) override
+	{
+		m_vol = vol;
+	}
 };
 
 
@@ -105,19 +149,22 @@ public:
 
 //Concrete Derived SDE class : Constant Elasticity of Variance (CEV) 
 //Note: when beta = 1.0, CEV == GBM
-class CEV : public ISDE
+class CEV final : public ISDE
 {
 private:
 	double m_mu;		// r
 	double m_vol;		// Constant volatility
 	double m_div;		// Constant dividend yield
 	double m_beta;      // Beta
+	double m_sigma;		// volatility input, m_vol = m_sigma * m_scale
+	double m_scale;		// IC^(1 - beta), fixed at construction so the local volatility does not move with the IC
 public:
 	//Constructor
 	CEV(double driftCoeff, double diffusionCoeff, double dividend, double initialCondition, double expiry, double beta)
-		: ISDE(initialCondition, expiry), m_mu(driftCoeff), m_div(dividend), m_beta(beta)
+		: ISDE(initialCondition, expiry), m_mu(driftCoeff), m_div(dividend), m_beta(beta), m_sigma(diffusionCoeff)
 	{
-		m_vol = diffusionCoeff * std::pow(initialCondition, 1.0 - beta);
+		m_scale = std::pow(initialCondition, 1.0 - beta);
+		m_vol = diffusionCoeff * m_scale;
 	}
 
 	//Derived Functions below
@@ -148,6 +195,26 @@ public:
 			return m_vol * m_beta / std::pow(x, 1.0 - m_beta);
 		}
 	}
+
+	//Derivatives for the Greeks
+	double DriftDerivative(double x) override
+	{
+		return m_mu - m_div;
+	}
+	double DiffusionSecondDerivative(double x) override
+	{
+		return m_vol * m_beta * (m_beta - 1.0) * std::pow(x, m_beta - 2.0);
+	}
+
+	double Volatility() const override
+	{
+		return m_sigma;
+	}
+	void Volatility(double vol) override
+	{
+		m_sigma = vol;
+		m_vol = vol * m_scale;
+	}
 };
 
 #endif
@@ -0,0 +1,436 @@
+//
+// Sobol.hpp
+//
+// Quasi Monte Carlo for the FDM: Sobol low discrepancy points mapped to the normals consumed by IFDM::advance
+//
+// SobolSequence : points of the Sobol sequence with Gray code generation, skip ahead and an optional random digital shift
+// BrownianBridge : maps independent normals to the increments of a path, the first normal builds the end point
+// SobolRNG : IRNG giving one Sobol point per path. Fill(out, NT) returns the NT normal increments of the next path, the
+//		dimension is fixed by the first Fill call. With PathLength(NT) only the first NT normals of a longer Fill come
+//		from the Sobol point and the Brownian bridge, the rest from a pseudo random stream, so auxiliary draws (the bridge
+//		extremes of continuous monitoring) do not take the best dimensions from the path
+//
+// The direction numbers are Joe and Kuo's new-joe-kuo-6.21201 (primitive polynomials and initial numbers m_k chosen
+// for good two dimensional projections), as bundled with Boost.Random for the first 3667 dimensions. Further dimensions
+// take the next primitive polynomials found at run time with odd m_k < 2^k drawn once from a fixed seed, still a valid
+// Sobol sequence but without the tuned projections
+//
+// Point 0 of the unscrambled sequence is the origin, which maps to about -6.35 in every normal, SobolRNG skips it
+//
+// With a digital shift, independent seeds give independent replications of the same low discrepancy point set, their
+// spread is the randomized QMC error estimate (MCMediator::startRQMC)
+//
+//
+
+#ifndef SOBOL_HPP
+#define SOBOL_HPP
+
+#include"RNG.hpp"
+#include<boost\random\sobol.hpp>		//for the Joe Kuo direction numbers
+#include<vector>
+#include<random>
+#include<cmath>
+#include<cstdint>
+#include<cstddef>
+#include<stdexcept>
+
+//Concrete class : Sobol sequence in any number of dimensions, 32 bit resolution
+class SobolSequence
+{
+private:
+	static const int Bits = 32;
+
+	std::size_t m_dim;									//number of dimensions
+	std::vector<std::uint32_t> m_directions;			//Bits direction numbers per dimension
+	std::vector<std::uint32_t> m_shift;					//digital shift per dimension, 0 = unscrambled
+	std::vector<std::uint32_t> m_x;						//current point (without the shift)
+	std::uint64_t m_index;								//index of the current point
+
+	//x^e mod p over GF(2), polynomials as bit masks, p of degree s
+	static std::uint64_t PowerMod(std::uint64_t e, std::uint64_t p, int s)
+	{
+		std::uint64_t result = 1, base = 2;		//the polynomials 1 and x
+		while (e)
+		{
+			if (e & 1)
+				result = MulMod(result, base, p, s);
+			base = MulMod(base, base, p, s);
+			e >>= 1;
+		}
+		return result;
+	}
+
+	static std::uint64_t MulMod(std::uint64_t a, std::uint64_t b, std::uint64_t p, int s)
+	{
+		std::uint64_t result = 0;
+		while (b)
+		{
+			if (b & 1)
+				result ^= a;
+			b >>= 1;
+			a <<= 1;
+			if (a >> s & 1)
+				a ^= p;
+		}
+		return result;
+	}
+
+	//p of degree s is primitive if x has order exactly 2^s - 1 modulo p
+	static bool IsPrimitive(std::uint64_t p, int s)
+	{
+		std::uint64_t order = (std::uint64_t(1) << s) - 1;
+		if (PowerMod(order, p, s) != 1)
+			return false;
+
+		std::uint64_t rest = order;
+		for (std::uint64_t q = 2; q * q <= rest; q++)
+		{
+			if (rest % q != 0)
+				continue;
+			while (rest % q == 0)
+				rest /= q;
+			if (PowerMod(order / q, p, s) == 1)
+				return false;
+		}
+		if (rest > 1 && rest != order && PowerMod(order / rest, p, s) == 1)
+			return false;
+		return true;
+	}
+
+	//first n primitive polynomials, degree 1 (x + 1) first
+	static std::vector<std::uint64_t> PrimitivePolynomials(std::size_t n)
+	{
+		std::vector<std::uint64_t> result;
+		for (int s = 1; result.size() < n; s++)
+		{
+			//leading and constant coefficients are 1, the middle ones run through all patterns
+			for (std::uint64_t middle = 0; middle < (std::uint64_t(1) << (s - 1)) && result.size() < n; middle++)
+			{
+				std::uint64_t p = (std::uint64_t(1) << s) | (middle << 1) | 1;
+				if (IsPrimitive(p, s))
+					result.push_back(p);
+			}
+		}
+		return result;
+	}
+
+	static int Degree(std::uint64_t p)
+	{
+		int s = 0;
+		while (p >> (s + 1))
+			s++;
+		return s;
+	}
+public:
+	//Constructor
+	SobolSequence(std::size_t dimension) : m_dim(dimension), m_directions(dimension * Bits), m_shift(dimension, 0),
+		m_x(dimension, 0), m_index(0)
+	{
+		//first dimension is van der Corput, v_k = 2^(32-k)
+		for (int k = 0; k < Bits; k++)
+			m_directions[k] = std::uint32_t(1) << (Bits - 1 - k);
+
+		//the table lists every primitive polynomial up to degree 15 in the order of the search, so the search only runs
+		//for the dimensions past it
+		typedef boost::random::default_sobol_table Table;
+		std::vector<std::uint64_t> polynomials;
+		if (dimension > Table::max_dimension)
+			polynomials = PrimitivePolynomials(dimension - 1);
+		std::mt19937 initial(20240613);		//fixed, the direction numbers are part of the sequence's definition
+		std::vector<std::uint32_t> m(Bits);
+
+		for (std::size_t j = 1; j < dimension; j++)
+		{
+			bool tabulated = j < Table::max_dimension;
+			std::uint64_t p = tabulated ? Table::polynomial(j - 1) : polynomials[j - 1];
+			int s = Degree(p);
+
+			//odd initial numbers m_k < 2^k (m[k] is m_(k+1))
+			for (int k = 0; k < s && k < Bits; k++)
+				m[k] = tabulated ? std::uint32_t(Table::minit(j - 1, k)) : (initial() & ((std::uint32_t(2) << k) - 1)) | 1;
+
+			//m_k = 2 a_1 m_(k-1) ^ 4 a_2 m_(k-2) ^ ... ^ 2^s m_(k-s) ^ m_(k-s)
+			for (int k = s; k < Bits; k++)
+			{
+				std::uint32_t value = m[k - s] ^ (m[k - s] << s);
+				for (int i = 1; i < s; i++)
+				{
+					if (p >> (s - i) & 1)
+						value ^= m[k - i] << i;
+				}
+				m[k] = value;
+			}
+
+			for (int k = 0; k < Bits; k++)
+				m_directions[j * Bits + k] = m[k] << (Bits - 1 - k);
+		}
+	}
+
+	std::size_t Dimension() const
+	{
+		return m_dim;
+	}
+
+	//random digital shift from the seed, independent seeds give independent replications
+	void Scramble(unsigned long seed)
+	{
+		std::seed_seq seq{ seed };
+		std::vector<std::uint32_t> shift(m_dim);
+		seq.generate(shift.begin(), shift.end());
+		m_shift = shift;
+	}
+
+	//jump to point index in O(dimension * 32), the point at index is x = XOR of v_k over the bits of gray(index)
+	void Seek(std::uint64_t index)
+	{
+		std::uint64_t gray = index ^ (index >> 1);
+		for (std::size_t j = 0; j < m_dim; j++)
+		{
+			std::uint32_t x = 0;
+			for (int k = 0; k < Bits; k++)
+			{
+				if (gray >> k & 1)
+					x ^= m_directions[j * Bits + k];
+			}
+			m_x[j] = x;
+		}
+		m_index = index;
+	}
+
+	//write the current point to u, each coordinate in (0,1), and move to the next one (Gray code: one XOR per dimension)
+	void Next(double* u)
+	{
+		for (std::size_t j = 0; j < m_dim; j++)
+			u[j] = ((m_x[j] ^ m_shift[j]) + 0.5) / 4294967296.0;	//centre of the cell, never 0 or 1
+
+		int c = 0;
+		while (m_index >> c & 1)
+			c++;
+		for (std::size_t j = 0; j < m_dim; j++)
+			m_x[j] ^= m_directions[j * Bits + c];
+		m_index++;
+	}
+
+	std::uint64_t Index() const
+	{
+		return m_index;
+	}
+};
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+//Concrete class : Brownian bridge on n equal steps
+//Normal 0 sets the end point, normal 1 the midpoint and so on, so the first (best distributed) Sobol dimensions carry
+//most of the path's variance. Transform returns the n increments divided by sqrt(dt), i.e. standard normals again
+class BrownianBridge
+{
+private:
+	std::size_t m_n;
+	std::vector<std::size_t> m_left, m_right, m_bridge;		//left and right neighbours already built, point to build
+	std::vector<double> m_leftWeight, m_rightWeight, m_sd;
+	std::vector<double> m_path;								//W(1), ..., W(n) in units of one step
+public:
+	//Constructor
+	BrownianBridge(std::size_t n) : m_n(n), m_left(n), m_right(n), m_bridge(n), m_leftWeight(n), m_rightWeight(n), m_sd(n), m_path(n)
+	{
+		if (n == 0)
+			return;
+
+		//time of point i is i + 1 steps
+		std::vector<std::size_t> built(n, 0);
+		built[n - 1] = 1;
+		m_bridge[0] = n - 1;
+		m_sd[0] = std::sqrt(double(n));
+
+		std::size_t j = 0;
+		for (std::size_t i = 1; i < n; i++)
+		{
+			//next gap [j, k) between built points, fill its middle
+			while (built[j])
+				j++;
+			std::size_t k = j;
+			while (!built[k])
+				k++;
+			std::size_t l = j + ((k - 1 - j) >> 1);
+			built[l] = i + 1;
+
+			double tl = double(l + 1), tk = double(k + 1), tj = double(j);		//tj is the time of the built point left of the gap
+			m_bridge[i] = l;
+			m_left[i] = j;
+			m_right[i] = k;
+			m_leftWeight[i] = (tk - tl) / (tk - tj);
+			m_rightWeight[i] = (tl - tj) / (tk - tj);
+			m_sd[i] = std::sqrt((tl - tj) * (tk - tl) / (tk - tj));
+
+			j = k + 1;
+			if (j >= n)
+				j = 0;
+		}
+	}
+
+	std::size_t Size() const
+	{
+		return m_n;
+	}
+
+	//n independent normals in, n independent standard normal increments out (in place is allowed)
+	void Transform(const double* z, double* increments)
+	{
+		if (m_n == 0)
+			return;
+
+		m_path[m_n - 1] = m_sd[0] * z[0];
+		for (std::size_t i = 1; i < m_n; i++)
+		{
+			std::size_t j = m_left[i], k = m_right[i], l = m_bridge[i];
+			double left = j > 0 ? m_path[j - 1] : 0.0;		//W(0) = 0
+			m_path[l] = m_leftWeight[i] * left + m_rightWeight[i] * m_path[k] + m_sd[i] * z[i];
+		}
+
+		increments[0] = m_path[0];
+		for (std::size_t i = 1; i < m_n; i++)
+			increments[i] = m_path[i] - m_path[i - 1];
+	}
+};
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+//Concrete Derived RNG class : Sobol quasi random normals, one point per path
+class SobolRNG final : public IRNG
+{
+private:
+	bool m_scramble;					//random digital shift from the seed
+	unsigned long m_seed;
+	bool m_bridge;						//Brownian bridge construction, otherwise dimension n drives step n
+	std::size_t m_pointsPerStream;		//Stream(seed, s) starts at point s * m_pointsPerStream
+	std::uint64_t m_start;				//first point of this generator
+	std::size_t m_pathLength;			//normals of a Fill taken from the Sobol point, 0 = all of them
+
+	std::mt19937 m_auxiliary;			//pseudo random normals after the first m_pathLength, seeded from (seed, start)
+	std::normal_distribution<double> m_normal;
+
+	std::shared_ptr<SobolSequence> m_sequence;		//created by the first Fill, it fixes the dimension
+	std::shared_ptr<BrownianBridge> m_brownian;
+	std::vector<double> m_point;		//normals of the current point, for GenerateRng
+	std::size_t m_next;					//next coordinate of m_point returned by GenerateRng
+
+	//n normals per Fill, the first m_pathLength of them (all if 0) from the Sobol point
+	void SetDimension(std::size_t n)
+	{
+		std::size_t dimension = (m_pathLength > 0 && m_pathLength < n) ? m_pathLength : n;
+		m_sequence = std::make_shared<SobolSequence>(dimension);
+		if (m_scramble)
+			m_sequence->Scramble(m_seed);
+		m_sequence->Seek(m_scramble ? m_start : m_start + 1);		//the origin is skipped unscrambled
+		if (m_bridge)
+			m_brownian = std::make_shared<BrownianBridge>(dimension);
+
+		std::seed_seq seq{ std::uint32_t(m_seed), std::uint32_t(m_start), std::uint32_t(m_start >> 32) };
+		m_auxiliary.seed(seq);
+		m_normal.reset();
+
+		m_point.resize(n);
+		m_next = n;
+	}
+public:
+	//Constructor
+	//pointsPerStream should match the paths per parallel work item (MCMediator::ChunkSize) so the chunks of a parallel
+	//run are consecutive slices of one sequence
+	SobolRNG(bool scramble = true, unsigned long seed = 0, bool brownianBridge = true, std::size_t pointsPerStream = 1024)
+		: IRNG(), m_scramble(scramble), m_seed(seed), m_bridge(brownianBridge), m_pointsPerStream(pointsPerStream), m_start(0), m_pathLength(0), m_next(0)
+	{
+		//coordinate by coordinate through the current point, a one dimensional sequence if Fill was never called
+		rng = [&]()
+		{
+			if (!m_sequence)
+				SetDimension(1);
+			if (m_next == m_point.size())
+			{
+				Fill(m_point.data(), m_point.size());
+				m_next = 0;
+			}
+			return m_point[m_next++];
+		};
+	}
+
+	//Acklam's rational approximation of the inverse normal cdf, refined by one Halley step to full double precision
+	static double InverseNormal(double p)
+	{
+		static const double a[] = { -3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02, 1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00 };
+		static const double b[] = { -5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02, 6.680131188771972e+01, -1.328068155288572e+01 };
+		static const double c[] = { -7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00, -2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00 };
+		static const double d[] = { 7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00, 3.754408661907416e+00 };
+		const double low = 0.02425;
+
+		double x;
+		if (p < low)
+		{//lower tail
+			double q = std::sqrt(-2 * std::log(p));
+			x = (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) / ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1);
+		}
+		else if (p <= 1 - low)
+		{//central region
+			double q = p - 0.5;
+			double r = q * q;
+			x = (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q / (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1);
+		}
+		else
+		{//upper tail
+			double q = std::sqrt(-2 * std::log(1 - p));
+			x = -(((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) / ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1);
+		}
+
+		double e = 0.5 * std::erfc(-x / std::sqrt(2.0)) - p;
+		double u = e * std::sqrt(2 * boost::math::constants::pi<double>()) * std::exp(x * x / 2);
+		return x - u / (1 + x * u / 2);
+	}
+
+	//n normals of the next Sobol point (one path), n must be the same on every call
+	virtual void Fill(double* out, std::size_t n) override
+	{
+		if (!m_sequence)
+			SetDimension(n);
+		if (n != m_point.size())
+			throw std::invalid_argument("SobolRNG::Fill : every point must have the dimension of the first one");
+
+		std::size_t dimension = m_sequence->Dimension();
+		m_sequence->Next(out);
+		for (std::size_t i = 0; i < dimension; i++)
+			out[i] = InverseNormal(out[i]);
+
+		if (m_bridge)
+			m_brownian->Transform(out, out);
+
+		for (std::size_t i = dimension; i < n; i++)
+			out[i] = m_normal(m_auxiliary);
+	}
+
+	//the Sobol point and the Brownian bridge cover the first n normals of every Fill, a new length restarts the sequence
+	virtual void PathLength(std::size_t n) override
+	{
+		if (n == m_pathLength)
+			return;
+		m_pathLength = n;
+		m_sequence.reset();
+		m_brownian.reset();
+	}
+
+	//same sequence and digital shift, starting stream * pointsPerStream points further
+	//a replication with an independent shift is a new generator with another seed
+	virtual std::shared_ptr<IRNG> Stream(unsigned long seed, unsigned long stream) const override
+	{
+		auto result = std::make_shared<SobolRNG>(m_scramble, seed, m_bridge, m_pointsPerStream);
+		result->m_start = std::uint64_t(stream) * m_pointsPerStream;
+		result->m_pathLength = m_pathLength;
+		return result;
+	}
+};
+
+#endif
+
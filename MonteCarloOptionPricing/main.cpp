@@ -10,11 +10,12 @@
 #include<iostream>
 #include<algorithm>
 #include<string>
-#include<numeric>
 #include<set>
 #include<boost\algorithm\string.hpp>
 #include<boost\lexical_cast.hpp>
 #include"Mediator.hpp"
+#include"ControlVariate.hpp"
+#include"MLMC.hpp"
 
 //Getting user input in runtime
 OptionTuple GetInput()
@@ -95,61 +96,45 @@ std::vector<double> Interface()
 	PayoffFunction Call = [&](const double& x) { return std::max(0.0, x - std::get<4>(option_data));  };
 	PayoffFunction Put = [&](const double& x) {  return std::max(0.0, std::get<4>(option_data) - x);  };
 
-	//Common Average functions for Asian Options
+	//Digital(cash or nothing) payoffs, pay 1 in the money
+	PayoffFunction DigitalCall = [&](const double& x) { return x > std::get<4>(option_data) ? 1.0 : 0.0;  };
+	PayoffFunction DigitalPut = [&](const double& x) { return x < std::get<4>(option_data) ? 1.0 : 0.0;  };
+
+	//Common Average functions for Asian Options, from the running sums of the path
 	//Arithmetic Average
-	AverageFunction ArithmeticAverage = [](const std::vector<double>& arr)
+	AverageFunction ArithmeticAverage = [](const PathState& path)
 	{
-		return (std::accumulate(arr.begin(), arr.end(), 0.0) / double(arr.size()));
+		return path.sum / double(path.points);
 	};
 
-	//Geometric Average
-	AverageFunction GeometricAverage = [](const std::vector<double>& arr)
+	//Geometric Average, from the sum of the logs so it does not overflow for large NT
+	AverageFunction GeometricAverage = [](const PathState& path)
 	{
-		return std::pow(std::accumulate(arr.begin(), arr.end(), 1.0, std::multiplies<double>()), 1.0 / double(arr.size()));
+		return std::exp(path.LogSum() / double(path.points));
 	};
 
 	double barrier = 0;		//will be getting/changed in rumtime , captured variable
 							//Some typical functions for barrier options(false = calculate payoff, true = don't calculate payoff)
-	KnockFunction UpAndIn = [&barrier](const std::vector<double>& v)
+	KnockFunction UpAndIn = [&barrier](const PathState& path)
 	{
-		for (auto it = v.begin(); it != v.end(); ++it)
-		{
-			//if any value >= upper limit -- IN
-			if (*it >= barrier)
-				return false;
-		}
-		return true;
+		//if any value >= upper limit -- IN
+		return !(path.max >= barrier);
 	};
-	KnockFunction UpAndOut = [&barrier](const std::vector<double>& v)
+	KnockFunction UpAndOut = [&barrier](const PathState& path)
 	{
-		for (auto it = v.begin(); it != v.end(); ++it)
-		{
-			//if any value is >= upper limit -- OUT
-			if (*it >= barrier)
-				return true;
-		}
-		return false;
+		//if any value is >= upper limit -- OUT
+		return path.max >= barrier;
 	};
-	KnockFunction DownAndIn = [&barrier](const std::vector<double>& v)
+	KnockFunction DownAndIn = [&barrier](const PathState& path)
 	{
-		for (auto it = v.begin(); it != v.end(); ++it)
-		{
-			//if any value <= lower limit -- IN
-			if (*it <= barrier)
-				return false;
-		}
-		return true;
+		//if any value <= lower limit -- IN
+		return !(path.min <= barrier);
 	};
 
-	KnockFunction DownAndOut = [&barrier](const std::vector<double> v)
+	KnockFunction DownAndOut = [&barrier](const PathState& path)
 	{
-		for (auto it = v.begin(); it != v.end(); ++it)
-		{
-			//if any value is <= lower limit -- OUT
-			if (*it <= barrier)
-				return true;
-		}
-		return false;
+		//if any value is <= lower limit -- OUT
+		return path.min <= barrier;
 	};
 
 	std::string option_choices;	//choices as a string, expected input : e.g. 1,3,4,5,9,10
@@ -168,11 +153,40 @@ std::vector<double> Interface()
 	std::cout << "12 = Barrier Put(Up-And-Out).\n";
 	std::cout << "13 = Barrier Put(Down-And-In).\n";
 	std::cout << "14 = Barrier Put(Down-And-Out).\n";
+	std::cout << "15 = Digital Call.\n";
+	std::cout << "16 = Digital Put.\n";
 	std::cout << "Enter the options indexes that you wish to calculate prices for(seperate by commas(,)) : \n";
 	std::cin >> option_choices; //expected input : e.g. 1,3,4,5,9,10
 
 	std::set<int> choices = ToSet(option_choices);	//convert the string input into set of ints(non-repeat)
 
+	//variance reduction, the control variates are the closed form European and geometric Asian prices (not for barriers)
+	int antithetic, control;
+	std::cout << "Enter 1 to use antithetic paths(0 = no) : ";
+	std::cin >> antithetic;
+	std::cout << "Enter 1 to use control variates(0 = no) : ";
+	std::cin >> control;
+
+	mediator.EnableAntithetic(antithetic == 1);
+	if (control == 1)
+		mediator.EnableControlVariate(std::get<0>(option_data), std::get<1>(option_data), std::get<2>(option_data));
+
+	//control variate of a European(option 1, 2) or Asian(option 3 - 6) pricer
+	auto AttachControl = [&](PricerPointer pricer, int choice)
+	{
+		if (control != 1 || choice > 6)
+			return pricer;
+
+		bool isCall = (choice == 1 || choice == 3 || choice == 4);
+		double r = std::get<0>(option_data), v = std::get<1>(option_data), d = std::get<2>(option_data);
+		double S0 = std::get<3>(option_data), K = std::get<4>(option_data), T = std::get<5>(option_data);
+		if (choice <= 2)
+			pricer->SetControlVariate(EuropeanControl(isCall, K, S0, r, v, d, T));
+		else
+			pricer->SetControlVariate(GeometricAsianControl(isCall, K, S0, r, v, d, T, std::get<1>(builder)->m_NT));
+		return pricer;
+	};
+
 	std::vector<PricerPointer> p;		//to store the selected pricers
 
 	bool change_barrier = false;		//to signal if we need to change the barrier
@@ -186,28 +200,33 @@ std::vector<double> Interface()
 				std::cout << "Enter Barrier : ";
 				std::cin >> barrier;
 				change_barrier = true;		//set to true, so no more reset
+
+				int continuous;
+				std::cout << "Enter 1 to monitor the barrier continuously(Brownian bridge, 0 = at the NT points only) : ";
+				std::cin >> continuous;
+				mediator.EnableContinuousMonitoring(continuous == 1);
 			}
 		}
 
 		switch (*it)
 		{
 		case 1://European Call
-			p.push_back(std::make_shared<EuropeanPricer>(Call, Dis));
+			p.push_back(AttachControl(std::make_shared<EuropeanPricer>(Call, Dis), 1));
 			break;
 		case 2://European Put
-			p.push_back(std::make_shared<EuropeanPricer>(Put, Dis));
+			p.push_back(AttachControl(std::make_shared<EuropeanPricer>(Put, Dis), 2));
 			break;
 		case 3://Asian Arithmetic Call
-			p.push_back(std::make_shared<AsianPricer>(Call, Dis, ArithmeticAverage));
+			p.push_back(AttachControl(std::make_shared<AsianPricer>(Call, Dis, ArithmeticAverage), 3));
 			break;
 		case 4://Asian Geometric Call
-			p.push_back(std::make_shared<AsianPricer>(Call, Dis, GeometricAverage));
+			p.push_back(AttachControl(std::make_shared<AsianPricer>(Call, Dis, GeometricAverage), 4));
 			break;
 		case 5://Asian Arithmetic Put
-			p.push_back(std::make_shared<AsianPricer>(Put, Dis, ArithmeticAverage));
+			p.push_back(AttachControl(std::make_shared<AsianPricer>(Put, Dis, ArithmeticAverage), 5));
 			break;
 		case 6://Asian Geometric Put
-			p.push_back(std::make_shared<AsianPricer>(Put, Dis, GeometricAverage));
+			p.push_back(AttachControl(std::make_shared<AsianPricer>(Put, Dis, GeometricAverage), 6));
 			break;
 		case 7://Barrier Call(Up-And-In)
 			p.push_back(std::make_shared<BarrierPricer>(Call, Dis, UpAndIn));
@@ -233,6 +252,14 @@ std::vector<double> Interface()
 		case 14://Barrier Put(Down-And-Out)
 			p.push_back(std::make_shared<BarrierPricer>(Put, Dis, DownAndOut));
 			break;
+		case 15://Digital Call, the payoff jumps so its Greeks use the likelihood ratio
+			p.push_back(std::make_shared<EuropeanPricer>(DigitalCall, Dis));
+			p.back()->UseLikelihoodRatio(true);
+			break;
+		case 16://Digital Put
+			p.push_back(std::make_shared<EuropeanPricer>(DigitalPut, Dis));
+			p.back()->UseLikelihoodRatio(true);
+			break;
 		default://invalid input
 			break;
 		}
@@ -244,8 +271,95 @@ std::vector<double> Interface()
 		mediator.AddPricer(*it);
 	}
 
+	int num_threads;
+	std::cout << "Enter the Number of threads(1 = single threaded, 0 = all cores) : ";
+	std::cin >> num_threads;
+
+	//quasi random paths are priced as randomized QMC replications, the error estimate comes from their spread
+	int num_replications = 0;
+	if (std::dynamic_pointer_cast<SobolRNG>(std::get<2>(builder)))
+	{
+		std::cout << "Enter the Number of RQMC replications(0 = single run) : ";
+		std::cin >> num_replications;
+	}
+
+	//a target standard error turns the number of simulations into a path budget
+	double target = 0;
+	if (num_replications <= 1)
+	{
+		std::cout << "Enter the target standard error(0 = run all the simulations) : ";
+		std::cin >> target;
+	}
+
+	//delta, gamma and vega next to the prices
+	int greeks = 0;
+	if (num_replications <= 1 && target <= 0)
+	{
+		std::cout << "Enter 1 to compute delta, gamma and vega(0 = no) : ";
+		std::cin >> greeks;
+	}
+
+	//multilevel Monte Carlo for the target, as a root mean square error over all the levels
+	int multilevel = 0;
+	if (target > 0)
+	{
+		std::cout << "Enter 1 to use multilevel Monte Carlo(0 = single level) : ";
+		std::cin >> multilevel;
+	}
+
 	//start calculating the price
-	mediator.start();
+	if (multilevel == 1)
+	{
+		unsigned long seed;
+		std::cout << "Enter the random seed : ";
+		std::cin >> seed;
+
+		MLMCDriver driver(builder);
+		for (auto it = p.begin(); it != p.end(); ++it)
+		{
+			driver.AddPricer(*it);
+		}
+		driver.start(target, seed);
+	}
+	else if (greeks == 1)
+	{
+		unsigned long seed;
+		std::cout << "Enter the random seed : ";
+		std::cin >> seed;
+		mediator.startGreeks(num_threads, seed);
+	}
+	else if (target > 0)
+	{
+		int relative;
+		double seconds;
+		unsigned long seed;
+		std::cout << "Enter 1 if the target is relative to the price(0 = absolute) : ";
+		std::cin >> relative;
+		std::cout << "Enter the time budget in seconds(0 = none) : ";
+		std::cin >> seconds;
+		std::cout << "Enter the random seed : ";
+		std::cin >> seed;
+
+		for (auto it = p.begin(); it != p.end(); ++it)
+		{
+			(*it)->SetTargetError(target, relative == 1);
+		}
+		mediator.startAdaptive(seed, seconds, num_threads);
+	}
+	else if (num_replications > 1)
+	{
+		unsigned long seed;
+		std::cout << "Enter the random seed : ";
+		std::cin >> seed;
+		mediator.startRQMC(num_replications, seed, num_threads);
+	}
+	else
+	{
+		unsigned long seed;
+		std::cout << "Enter the random seed : ";
+		std::cin >> seed;
+		mediator.startParallel(num_threads, seed);
+	}
 
 	//we can also store all the prices as a vector of pure numbers and return as a result
 	std::vector<double> final_prices;